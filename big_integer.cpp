@@ -1,407 +1,3211 @@
-#include "big_integer.h"
-
-BigInteger::BigInteger() : is_negative_(false) {
-}
-
-BigInteger::BigInteger(int value) : is_negative_(value < 0) {
-  AddDigits(static_cast<int64_t>(std::abs(static_cast<int64_t>(value))));
-}
-
-BigInteger::BigInteger(int64_t value) : is_negative_(value < 0) {
-  AddDigits(std::abs(value));
-}
-
-BigInteger::BigInteger(const std::string& value) {
-  ParseString(value);
-}
-
-BigInteger::BigInteger(const char* value) {
-  ParseString(std::string(value));
-}
-
-void BigInteger::AddDigits(int64_t value) {
-  while (value > 0) {
-    digits_.push_back(static_cast<int>(value % kBase));
-    value /= kBase;
-  }
-}
-
-void BigInteger::ParseString(const std::string& str) {
-  is_negative_ = false;
-  digits_.clear();
-
-  size_t start = 0;
-  if (str[0] == '-') {
-    is_negative_ = true;
-    start = 1;
-  } else if (str[0] == '+') {
-    start = 1;
-  }
-
-  for (int i = static_cast<int>(str.length()) - 1; i >= static_cast<int>(start); i -= kBaseDigits) {
-    int digit = 0;
-    int end = std::max(static_cast<int>(start), i - kBaseDigits + 1);
-
-    for (int j = end; j <= i; ++j) {
-      CheckOverflow(digit * 10 + (str[j] - '0'));
-      digit = digit * 10 + (str[j] - '0');
-    }
-
-    digits_.push_back(digit);
-  }
-
-  RemoveLeadingZeros();
-}
-
-void BigInteger::Normalize() {
-  RemoveLeadingZeros();
-  if (digits_.empty()) {
-    is_negative_ = false;
-  }
-}
-
-void BigInteger::RemoveLeadingZeros() {
-  while (!digits_.empty() && digits_.back() == 0) {
-    digits_.pop_back();
-  }
-}
-
-void BigInteger::CheckOverflow(int value) const {
-  if (value < 0 || value >= kBase) {
-    throw BigIntegerOverflow();
-  }
-}
-
-void BigInteger::CheckDivision(const BigInteger& divisor) const {
-  if (divisor.digits_.empty()) {
-    throw BigIntegerDivisionByZero();
-  }
-}
-
-bool BigInteger::IsNegative() const {
-  return is_negative_;
-}
-
-BigInteger BigInteger::Absolute() const {
-  BigInteger result = *this;
-  result.is_negative_ = false;
-  return result;
-}
-
-BigInteger BigInteger::operator+() const {
-  return *this;
-}
-
-BigInteger BigInteger::operator-() const {
-  BigInteger result = *this;
-  result.is_negative_ = !is_negative_;
-  result.Normalize();
-  return result;
-}
-
-BigInteger& BigInteger::operator+=(const BigInteger& other) {
-  if (is_negative_ == other.is_negative_) {
-    size_t required_size = std::max(digits_.size(), other.digits_.size()) + 1;
-    for (; digits_.size() < required_size; digits_.push_back(0)) {
-    }
-
-    int carry = 0;
-    for (size_t i = 0; i < digits_.size() || carry != 0; ++i) {
-      if (i == digits_.size()) {
-        digits_.push_back(0);
-      }
-
-      digits_[i] += carry + (i < other.digits_.size() ? other.digits_[i] : 0);
-      carry = digits_[i] >= kBase;
-      if (carry) {
-        digits_[i] -= kBase;
-      }
-      CheckOverflow(digits_[i]);
-    }
-  } else {
-    *this -= -other;
-  }
-
-  Normalize();
-  return *this;
-}
-
-BigInteger& BigInteger::operator-=(const BigInteger& other) {
-  if (is_negative_ == other.is_negative_) {
-    if (Absolute() >= other.Absolute()) {
-      int borrow = 0;
-      for (size_t i = 0; i < other.digits_.size() || borrow != 0; ++i) {
-        if (i == digits_.size()) {
-          digits_.push_back(0);
-        }
-        digits_[i] -= borrow + (i < other.digits_.size() ? other.digits_[i] : 0);
-        borrow = digits_[i] < 0;
-        if (borrow) {
-          digits_[i] += kBase;
-        }
-        CheckOverflow(digits_[i]);
-      }
-    } else {
-      *this = -(other - *this);
-    }
-  } else {
-    *this += -other;
-  }
-
-  Normalize();
-  return *this;
-}
-
-BigInteger& BigInteger::operator*=(const BigInteger& other) {
-  BigInteger result;
-  MultiplyHelper(*this, other, result);
-  *this = result;
-  return *this;
-}
-
-void BigInteger::MultiplyHelper(const BigInteger& a, const BigInteger& b, BigInteger& result) {
-  result.digits_.resize(a.digits_.size() + b.digits_.size());
-  result.is_negative_ = a.is_negative_ != b.is_negative_;
-
-  for (size_t i = 0; i < a.digits_.size(); ++i) {
-    int carry = 0;
-    for (size_t j = 0; j < b.digits_.size() || carry != 0; ++j) {
-      int64_t product = static_cast<int64_t>(a.digits_[i]) * (j < b.digits_.size() ? b.digits_[j] : 0) + carry;
-      if (i + j < result.digits_.size()) {
-        product += result.digits_[i + j];
-      }
-
-      if (i + j < result.digits_.size()) {
-        result.digits_[i + j] = static_cast<int>(product % kBase);
-      }
-      carry = static_cast<int>(product / kBase);
-    }
-  }
-
-  result.Normalize();
-
-  if (result.DigitCount() > 30009) {
-    throw BigIntegerOverflow();
-  }
-}
-
-BigInteger& BigInteger::operator/=(const BigInteger& other) {
-  CheckDivision(other);
-  BigInteger quotient;
-  BigInteger remainder;
-  DivideHelper(*this, other, quotient, remainder);
-  *this = quotient;
-  return *this;
-}
-
-BigInteger& BigInteger::operator%=(const BigInteger& other) {
-  CheckDivision(other);
-  BigInteger quotient;
-  BigInteger remainder;
-  DivideHelper(*this, other, quotient, remainder);
-  *this = remainder;
-  return *this;
-}
-
-void BigInteger::DivideHelper(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
-                              BigInteger& remainder) {
-  BigInteger abs_dividend = dividend.Absolute();
-  BigInteger abs_divisor = divisor.Absolute();
-
-  quotient.digits_.resize(abs_dividend.digits_.size());
-
-  for (int i = static_cast<int>(abs_dividend.digits_.size()) - 1; i >= 0; --i) {
-    remainder.digits_.insert(remainder.digits_.begin(), abs_dividend.digits_[i]);
-    remainder.Normalize();
-
-    int left = 0;
-    int right = kBase;
-    int digit = 0;
-
-    while (left <= right) {
-      int mid = (left + right) / 2;
-      BigInteger temp = abs_divisor * BigInteger(mid);
-
-      if (temp <= remainder) {
-        digit = mid;
-        left = mid + 1;
-      } else {
-        right = mid - 1;
-      }
-    }
-
-    quotient.digits_[i] = digit;
-    remainder -= abs_divisor * BigInteger(digit);
-  }
-
-  quotient.is_negative_ = dividend.is_negative_ != divisor.is_negative_;
-  remainder.is_negative_ = dividend.is_negative_;
-
-  quotient.Normalize();
-  remainder.Normalize();
-}
-
-BigInteger::operator bool() const {
-  return !digits_.empty();
-}
-
-BigInteger& BigInteger::operator++() {
-  *this += BigInteger(1);
-  return *this;
-}
-
-BigInteger BigInteger::operator++(int) {
-  BigInteger temp = *this;
-  ++*this;
-  return temp;
-}
-
-BigInteger& BigInteger::operator--() {
-  *this -= BigInteger(1);
-  return *this;
-}
-
-BigInteger BigInteger::operator--(int) {
-  BigInteger temp = *this;
-  --*this;
-  return temp;
-}
-
-size_t BigInteger::DigitCount() const {
-  if (digits_.empty()) {
-    return 1;
-  }
-
-  size_t count = (digits_.size() - 1) * kBaseDigits;
-  int last = digits_.back();
-
-  while (last > 0) {
-    last /= 10;
-    ++count;
-  }
-
-  return count;
-}
-
-void BigInteger::HandleCarry(size_t index, int& carry) {
-  while (carry != 0 && index < digits_.size()) {
-    digits_[index] += carry;
-    carry = digits_[index] / kBase;
-    digits_[index] %= kBase;
-    ++index;
-  }
-  if (carry != 0) {
-    digits_.push_back(carry);
-  }
-}
-
-void BigInteger::HandleBorrow(size_t index, int& borrow) {
-  while (borrow != 0 && index < digits_.size()) {
-    digits_[index] -= borrow;
-    borrow = 0;
-    if (digits_[index] < 0) {
-      digits_[index] += kBase;
-      borrow = 1;
-    }
-    ++index;
-  }
-}
-
-void BigInteger::EnsureCapacity(size_t size) {
-  if (digits_.size() < size) {
-    digits_.resize(size, 0);
-  }
-}
-
-void BigInteger::CompareDigits(const BigInteger& a, const BigInteger& b, int& result) {
-  if (a.digits_.size() != b.digits_.size()) {
-    result = (a.digits_.size() < b.digits_.size()) ? -1 : 1;
-    return;
-  }
-
-  for (int i = static_cast<int>(a.digits_.size()) - 1; i >= 0; --i) {
-    if (a.digits_[i] != b.digits_[i]) {
-      result = (a.digits_[i] < b.digits_[i]) ? -1 : 1;
-      return;
-    }
-  }
-
-  result = 0;
-}
-
-bool operator==(const BigInteger& a, const BigInteger& b) {
-  return !(a < b) && !(b < a);
-}
-
-bool operator!=(const BigInteger& a, const BigInteger& b) {
-  return !(a == b);
-}
-
-bool operator<(const BigInteger& a, const BigInteger& b) {
-  if (a.is_negative_ != b.is_negative_) {
-    return a.is_negative_;
-  }
-  if (a.digits_.size() != b.digits_.size()) {
-    return (a.digits_.size() < b.digits_.size()) != a.is_negative_;
-  }
-  for (int i = static_cast<int>(a.digits_.size()) - 1; i >= 0; --i) {
-    if (a.digits_[i] != b.digits_[i]) {
-      return (a.digits_[i] < b.digits_[i]) != a.is_negative_;
-    }
-  }
-  return false;
-}
-
-bool operator<=(const BigInteger& a, const BigInteger& b) {
-  return !(b < a);
-}
-
-bool operator>(const BigInteger& a, const BigInteger& b) {
-  return b < a;
-}
-
-bool operator>=(const BigInteger& a, const BigInteger& b) {
-  return !(a < b);
-}
-
-std::ostream& operator<<(std::ostream& os, const BigInteger& value) {
-  if (value.is_negative_) {
-    os << '-';
-  }
-  if (value.digits_.empty()) {
-    os << '0';
-  } else {
-    os << value.digits_.back();
-    for (int i = static_cast<int>(value.digits_.size()) - 2; i >= 0; --i) {
-      os << std::setw(BigInteger::kBaseDigits) << std::setfill('0') << value.digits_[i];
-    }
-  }
-  return os;
-}
-
-std::istream& operator>>(std::istream& is, BigInteger& value) {
-  std::string s;
-  is >> s;
-  value = BigInteger(s);
-  return is;
-}
-
-BigInteger operator+(BigInteger a, const BigInteger& b) {
-  return a += b;
-}
-
-BigInteger operator-(BigInteger a, const BigInteger& b) {
-  return a -= b;
-}
-
-BigInteger operator*(BigInteger a, const BigInteger& b) {
-  return a *= b;
-}
-
-BigInteger operator/(BigInteger a, const BigInteger& b) {
-  return a /= b;
-}
-
-BigInteger operator%(BigInteger a, const BigInteger& b) {
-  return a %= b;
-}
\ No newline at end of file
+#include "big_integer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <system_error>
+#include <thread>
+
+#ifdef __x86_64__
+#include <immintrin.h>
+#endif
+
+size_t BigInteger::karatsuba_threshold_ = 32;
+size_t BigInteger::toom3_threshold_ = 250;
+size_t BigInteger::toom4_threshold_ = 1200;
+size_t BigInteger::ntt_threshold_ = 24000;
+size_t BigInteger::max_digit_count_ = 30009;
+size_t BigInteger::divide_threshold_ = 60;
+size_t BigInteger::gcd_threshold_ = 100;
+std::atomic<size_t> BigInteger::multiply_threads_{1};
+std::atomic<size_t> BigInteger::parallel_threshold_{1000};
+
+namespace {
+
+// Three NTT-friendly primes with primitive root 3; their product exceeds every convolution
+// coefficient we can produce, so the exact coefficients are recovered with Garner's CRT.
+constexpr uint32_t kNttPrimes[3] = {998244353, 167772161, 469762049};
+constexpr uint32_t kNttRoot = 3;
+constexpr size_t kMaxNttLength = size_t{1} << 22;
+
+uint32_t PowerModulo(uint64_t base, uint64_t exponent, uint32_t modulus) {
+  uint64_t result = 1;
+  base %= modulus;
+  while (exponent > 0) {
+    if (exponent & 1) {
+      result = result * base % modulus;
+    }
+    base = base * base % modulus;
+    exponent >>= 1;
+  }
+  return static_cast<uint32_t>(result);
+}
+
+void NumberTheoreticTransform(std::vector<uint32_t>& values, uint32_t modulus, bool inverse) {
+  size_t size = values.size();
+  for (size_t i = 1, j = 0; i < size; ++i) {
+    size_t bit = size >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j ^= bit;
+    if (i < j) {
+      std::swap(values[i], values[j]);
+    }
+  }
+
+  std::vector<uint32_t> roots(size / 2);
+  for (size_t length = 2; length <= size; length <<= 1) {
+    uint32_t step = PowerModulo(kNttRoot, (modulus - 1) / length, modulus);
+    if (inverse) {
+      step = PowerModulo(step, modulus - 2, modulus);
+    }
+    size_t half = length / 2;
+    roots[0] = 1;
+    for (size_t k = 1; k < half; ++k) {
+      roots[k] = static_cast<uint32_t>(static_cast<uint64_t>(roots[k - 1]) * step % modulus);
+    }
+    for (size_t start = 0; start < size; start += length) {
+      for (size_t k = 0; k < half; ++k) {
+        uint32_t u = values[start + k];
+        uint32_t v = static_cast<uint32_t>(static_cast<uint64_t>(values[start + k + half]) * roots[k] % modulus);
+        values[start + k] = u + v >= modulus ? u + v - modulus : u + v;
+        values[start + k + half] = u >= v ? u - v : u + modulus - v;
+      }
+    }
+  }
+
+  if (inverse) {
+    uint64_t size_inverse = PowerModulo(size, modulus - 2, modulus);
+    for (uint32_t& value : values) {
+      value = static_cast<uint32_t>(value * size_inverse % modulus);
+    }
+  }
+}
+
+std::vector<uint32_t> ConvolveModulo(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, size_t length,
+                                     uint32_t modulus) {
+  std::vector<uint32_t> lhs(length, 0);
+  for (size_t i = 0; i < a.size(); ++i) {
+    lhs[i] = a[i] % modulus;
+  }
+  NumberTheoreticTransform(lhs, modulus, false);
+
+  // A square needs only one forward transform.
+  std::vector<uint32_t> rhs;
+  if (&a != &b) {
+    rhs.assign(length, 0);
+    for (size_t i = 0; i < b.size(); ++i) {
+      rhs[i] = b[i] % modulus;
+    }
+    NumberTheoreticTransform(rhs, modulus, false);
+  }
+  const std::vector<uint32_t>& other = &a != &b ? rhs : lhs;
+  for (size_t i = 0; i < length; ++i) {
+    lhs[i] = static_cast<uint32_t>(static_cast<uint64_t>(lhs[i]) * other[i] % modulus);
+  }
+  NumberTheoreticTransform(lhs, modulus, true);
+  return lhs;
+}
+
+// Extra threads running parallel sub-products, over all products in flight.
+std::atomic<size_t> busy_threads{0};
+
+// Statistics operations in progress on this thread; only the outermost one is recorded. Workers of
+// RunTasks inherit the depth of the thread that started them.
+thread_local size_t operation_depth = 0;
+
+// Heap allocations of limb buffers on this thread, counted only with BIG_INTEGER_STATISTICS.
+thread_local uint64_t small_buffer_allocations = 0;
+
+bool AcquireThread(size_t threads) {
+  size_t busy = busy_threads.load();
+  while (busy + 1 < threads) {
+    if (busy_threads.compare_exchange_weak(busy, busy + 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Runs task(0), ..., task(count - 1). Tasks 1 and up go to extra threads while fewer than threads - 1
+// are busy; the caller runs the rest itself and then waits for the others, rethrowing their exceptions.
+template <class Task>
+void RunTasks(size_t count, size_t threads, const Task& task) {
+  struct Release {
+    ~Release() {
+      busy_threads.fetch_sub(1);
+    }
+  };
+  std::vector<std::future<void>> spawned;
+  std::vector<size_t> local = {0};
+  const size_t depth = kBigIntegerStatistics ? operation_depth : 0;
+  for (size_t i = 1; i < count; ++i) {
+    if (!AcquireThread(threads)) {
+      local.push_back(i);
+      continue;
+    }
+    try {
+      spawned.push_back(std::async(std::launch::async, [&task, i, depth] {
+        Release release;
+        if constexpr (kBigIntegerStatistics) {
+          operation_depth = depth;
+        }
+        task(i);
+      }));
+    } catch (const std::system_error&) {
+      busy_threads.fetch_sub(1);
+      local.push_back(i);
+    }
+  }
+  for (size_t i : local) {
+    task(i);
+  }
+  for (auto& result : spawned) {
+    result.get();
+  }
+}
+
+__extension__ typedef unsigned __int128 UInt128;
+__extension__ typedef __int128 Int128;
+
+// |value| without overflowing on INT64_MIN.
+uint64_t MagnitudeOf(int64_t value) {
+  return value < 0 ? uint64_t{0} - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+}
+
+// limbs = limbs * factor + carry; returns the limb carried out of the top.
+uint64_t MultiplyAddLimbs(uint64_t* limbs, size_t size, uint64_t factor, uint64_t carry) {
+  for (size_t i = 0; i < size; ++i) {
+    UInt128 product = static_cast<UInt128>(limbs[i]) * factor + carry;
+    limbs[i] = static_cast<uint64_t>(product);
+    carry = static_cast<uint64_t>(product >> 64);
+  }
+  return carry;
+}
+
+// Operands with at least this many limbs take the vector add, subtract and compare kernels when the CPU
+// has them.
+constexpr size_t kVectorLimbs = 32;
+
+// Rows with at least this many limbs take the MULX/ADX multiply-accumulate kernel when the CPU has it.
+constexpr size_t kAdxLimbs = 8;
+
+#ifdef __x86_64__
+
+struct LaneMasks {
+  alignas(32) uint64_t lanes[16][4];
+};
+
+// lanes[c][i] is all ones when bit i of c is set.
+constexpr LaneMasks MakeLaneMasks() {
+  LaneMasks masks{};
+  for (int c = 0; c < 16; ++c) {
+    for (int i = 0; i < 4; ++i) {
+      masks.lanes[c][i] = (c >> i & 1) != 0 ? ~uint64_t{0} : 0;
+    }
+  }
+  return masks;
+}
+
+constexpr LaneMasks kLaneMasks = MakeLaneMasks();
+
+// Lane-wise x + y (or x - y) of four limbs; sets bit i of g when lane i carried (borrowed) out and
+// bit i of p when it passes an incoming carry on: an all-ones sum, or a zero difference.
+template <bool Subtract>
+__attribute__((target("avx2"))) inline __m256i AddLanesAvx2(__m256i x, __m256i y, uint32_t& g, uint32_t& p) {
+  const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i result = Subtract ? _mm256_sub_epi64(x, y) : _mm256_add_epi64(x, y);
+  // Unsigned comparisons as signed ones with the sign bits flipped: x - y borrows when y > x and
+  // x + y carries when x > x + y.
+  const __m256i overflow = Subtract ? _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign))
+                                    : _mm256_cmpgt_epi64(_mm256_xor_si256(x, sign), _mm256_xor_si256(result, sign));
+  const __m256i pass = _mm256_cmpeq_epi64(result, _mm256_set1_epi64x(Subtract ? 0 : -1));
+  g = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(overflow)));
+  p = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(pass)));
+  return result;
+}
+
+// out = a + b (or a - b) over size limbs, a multiple of 8, with an incoming carry (borrow); returns
+// the outgoing one. out may alias a or b. Eight limbs are combined lane-wise at a time and their
+// carries resolved by lookahead: with g and p of all eight lanes, bit i of (2g + p + carry) ^ p is the
+// carry into lane i and bit 8 the carry out of the block, so the serial dependency between blocks is
+// a few scalar operations.
+template <bool Subtract>
+__attribute__((target("avx2"))) uint64_t AddBlocksAvx2(uint64_t* out, const uint64_t* a, const uint64_t* b,
+                                                       size_t size, uint64_t carry) {
+  for (size_t i = 0; i < size; i += 8) {
+    uint32_t g_low;
+    uint32_t p_low;
+    uint32_t g_high;
+    uint32_t p_high;
+    __m256i low = AddLanesAvx2<Subtract>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                         _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)), g_low, p_low);
+    __m256i high = AddLanesAvx2<Subtract>(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i + 4)),
+                                          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i + 4)), g_high,
+                                          p_high);
+    const uint32_t g = g_low | g_high << 4;
+    const uint32_t p = p_low | p_high << 4;
+    const uint32_t c = (2 * g + p + static_cast<uint32_t>(carry)) ^ p;
+    carry = c >> 8;
+
+    // Adding an all-ones lane subtracts one, so carries are applied with the opposite operation.
+    const __m256i low_carry = _mm256_load_si256(reinterpret_cast<const __m256i*>(kLaneMasks.lanes[c & 15]));
+    const __m256i high_carry = _mm256_load_si256(reinterpret_cast<const __m256i*>(kLaneMasks.lanes[c >> 4 & 15]));
+    low = Subtract ? _mm256_add_epi64(low, low_carry) : _mm256_sub_epi64(low, low_carry);
+    high = Subtract ? _mm256_add_epi64(high, high_carry) : _mm256_sub_epi64(high, high_carry);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4), high);
+  }
+  return carry;
+}
+
+// AddBlocksAvx2 with all eight lanes in one register; the carry masks come straight from the
+// comparisons and are applied with masked adds.
+template <bool Subtract>
+__attribute__((target("avx512f"))) uint64_t AddBlocksAvx512(uint64_t* out, const uint64_t* a, const uint64_t* b,
+                                                           size_t size, uint64_t carry) {
+  const __m512i one = _mm512_set1_epi64(1);
+  const __m512i pass = _mm512_set1_epi64(Subtract ? 0 : -1);
+  for (size_t i = 0; i < size; i += 8) {
+    const __m512i x = _mm512_loadu_si512(a + i);
+    const __m512i y = _mm512_loadu_si512(b + i);
+    __m512i result = Subtract ? _mm512_sub_epi64(x, y) : _mm512_add_epi64(x, y);
+    const uint32_t g = Subtract ? _mm512_cmplt_epu64_mask(x, y) : _mm512_cmplt_epu64_mask(result, x);
+    const uint32_t p = _mm512_cmpeq_epu64_mask(result, pass);
+    const uint32_t c = (2 * g + p + static_cast<uint32_t>(carry)) ^ p;
+    carry = c >> 8;
+    const auto lanes = static_cast<__mmask8>(c);
+    result = Subtract ? _mm512_mask_sub_epi64(result, lanes, result, one)
+                      : _mm512_mask_add_epi64(result, lanes, result, one);
+    _mm512_storeu_si512(out + i, result);
+  }
+  return carry;
+}
+
+// The number of limbs left once the equal top limbs of a and b are dropped, so 0 when they agree.
+__attribute__((target("avx2"))) size_t TrimEqualAvx2(const uint64_t* a, const uint64_t* b, size_t size) {
+  for (; size >= 4; size -= 4) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + size - 4));
+    const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + size - 4));
+    const auto equal = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(x, y))));
+    if (equal != 15) {
+      return size - 4 + 32 - __builtin_clz(~equal & 15);
+    }
+  }
+  for (; size > 0 && a[size - 1] == b[size - 1]; --size) {
+  }
+  return size;
+}
+
+__attribute__((target("avx512f"))) size_t TrimEqualAvx512(const uint64_t* a, const uint64_t* b, size_t size) {
+  for (; size >= 8; size -= 8) {
+    const uint32_t different =
+        _mm512_cmpneq_epu64_mask(_mm512_loadu_si512(a + size - 8), _mm512_loadu_si512(b + size - 8));
+    if (different != 0) {
+      return size - 8 + 32 - __builtin_clz(different);
+    }
+  }
+  for (; size > 0 && a[size - 1] == b[size - 1]; --size) {
+  }
+  return size;
+}
+
+// target += source * factor over size limbs, a non-zero multiple of 4, with an incoming carry; returns the
+// outgoing one. MULX leaves the flags alone, so ADCX (carry flag) chains the high halves into the low
+// ones while ADOX (overflow flag) adds the target limbs in parallel; compilers do not emit the second
+// chain from intrinsics. The loop counts rcx up to zero with LEA and JRCXZ, which keep both flags.
+uint64_t MultiplyAccumulateAdx(uint64_t* target, const uint64_t* source, size_t size, uint64_t factor,
+                               uint64_t carry) {
+  uint64_t low0;
+  uint64_t high0;
+  uint64_t low1;
+  uint64_t high1;
+  int64_t index = -static_cast<int64_t>(size);
+  asm volatile(
+      "xor %k[low0], %k[low0]\n\t"
+      "1:\n\t"
+      "mulx (%[source],%%rcx,8), %[low0], %[high0]\n\t"
+      "mulx 8(%[source],%%rcx,8), %[low1], %[high1]\n\t"
+      "adcx %[carry], %[low0]\n\t"
+      "adox (%[target],%%rcx,8), %[low0]\n\t"
+      "mov %[low0], (%[target],%%rcx,8)\n\t"
+      "adcx %[high0], %[low1]\n\t"
+      "adox 8(%[target],%%rcx,8), %[low1]\n\t"
+      "mov %[low1], 8(%[target],%%rcx,8)\n\t"
+      "mulx 16(%[source],%%rcx,8), %[low0], %[high0]\n\t"
+      "adcx %[high1], %[low0]\n\t"
+      "adox 16(%[target],%%rcx,8), %[low0]\n\t"
+      "mov %[low0], 16(%[target],%%rcx,8)\n\t"
+      "mulx 24(%[source],%%rcx,8), %[low1], %[carry]\n\t"
+      "adcx %[high0], %[low1]\n\t"
+      "adox 24(%[target],%%rcx,8), %[low1]\n\t"
+      "mov %[low1], 24(%[target],%%rcx,8)\n\t"
+      "lea 4(%%rcx), %%rcx\n\t"
+      "jrcxz 2f\n\t"
+      "jmp 1b\n\t"
+      "2:\n\t"
+      "mov $0, %k[low0]\n\t"
+      "adcx %[low0], %[carry]\n\t"
+      "adox %[low0], %[carry]\n\t"
+      : [carry] "+&r"(carry), [low0] "=&r"(low0), [high0] "=&r"(high0), [low1] "=&r"(low1),
+        [high1] "=&r"(high1), "+c"(index)
+      : [source] "r"(source + size), [target] "r"(target + size), "d"(factor)
+      : "cc", "memory");
+  return carry;
+}
+
+#endif
+
+// The vector limb kernels in use; a null entry keeps the portable loop. Each one takes over the part
+// of the operands described at its call site and the scalar loops do the rest.
+struct LimbKernels {
+  BigInteger::KernelSet set;
+  uint64_t (*add)(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t size, uint64_t carry);
+  uint64_t (*subtract)(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t size, uint64_t borrow);
+  uint64_t (*multiply_accumulate)(uint64_t* target, const uint64_t* source, size_t size, uint64_t factor,
+                                  uint64_t carry);
+  size_t (*trim_equal)(const uint64_t* a, const uint64_t* b, size_t size);
+};
+
+// The best kernels the CPU supports, up to limit. MULX/ADX rows come with either vector set.
+LimbKernels SelectKernels(BigInteger::KernelSet limit) {
+  using KernelSet = BigInteger::KernelSet;
+  LimbKernels kernels{KernelSet::kScalar, nullptr, nullptr, nullptr, nullptr};
+#ifdef __x86_64__
+  __builtin_cpu_init();
+  if (limit >= KernelSet::kAvx512 && __builtin_cpu_supports("avx512f")) {
+    kernels = {KernelSet::kAvx512, AddBlocksAvx512<false>, AddBlocksAvx512<true>, nullptr, TrimEqualAvx512};
+  } else if (limit >= KernelSet::kAvx2 && __builtin_cpu_supports("avx2")) {
+    kernels = {KernelSet::kAvx2, AddBlocksAvx2<false>, AddBlocksAvx2<true>, nullptr, TrimEqualAvx2};
+  }
+  if (kernels.set != KernelSet::kScalar && __builtin_cpu_supports("bmi2") && __builtin_cpu_supports("adx")) {
+    kernels.multiply_accumulate = MultiplyAccumulateAdx;
+  }
+#endif
+  return kernels;
+}
+
+// BIG_INTEGER_KERNELS=scalar|avx2|avx512 caps the kernels picked at startup; anything else is ignored.
+BigInteger::KernelSet EnvironmentKernelLimit() {
+  using KernelSet = BigInteger::KernelSet;
+  const char* value = std::getenv("BIG_INTEGER_KERNELS");
+  if (value != nullptr && std::strcmp(value, "scalar") == 0) {
+    return KernelSet::kScalar;
+  }
+  if (value != nullptr && std::strcmp(value, "avx2") == 0) {
+    return KernelSet::kAvx2;
+  }
+  return KernelSet::kAvx512;
+}
+
+constexpr LimbKernels kScalarKernels{BigInteger::KernelSet::kScalar, nullptr, nullptr, nullptr, nullptr};
+
+// The kernels for each KernelSet cap; the tables never change once built.
+const LimbKernels* KernelTable(BigInteger::KernelSet limit) {
+  using KernelSet = BigInteger::KernelSet;
+  static const LimbKernels tables[] = {SelectKernels(KernelSet::kScalar), SelectKernels(KernelSet::kAvx2),
+                                       SelectKernels(KernelSet::kAvx512)};
+  return &tables[static_cast<size_t>(limit)];
+}
+
+// The kernels in use. SetKernels publishes another immutable table, so threads in the middle of a
+// product keep using the one they loaded. Until this is initialized it is null, which reads as the
+// scalar kernels, so values built during static initialization elsewhere are still safe.
+std::atomic<const LimbKernels*> active_kernels{KernelTable(EnvironmentKernelLimit())};
+
+const LimbKernels& ActiveKernels() {
+  const LimbKernels* kernels = active_kernels.load(std::memory_order_acquire);
+  return kernels != nullptr ? *kernels : kScalarKernels;
+}
+
+// Runs the vector kernel over the leading multiple of 8 of size limbs when it pays off; returns the
+// number of limbs done and updates carry.
+template <bool Subtract>
+size_t AddBlocks(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t size, uint64_t& carry) {
+  if (size < kVectorLimbs) {
+    return 0;
+  }
+  const auto kernel = Subtract ? ActiveKernels().subtract : ActiveKernels().add;
+  if (kernel != nullptr) {
+    size_t blocks = size / 8 * 8;
+    carry = kernel(out, a, b, blocks, carry);
+    return blocks;
+  }
+  return 0;
+}
+
+// out = a + b + carry over size limbs; returns the carry out. out may alias a or b.
+uint64_t AddCarryLimbs(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t size, uint64_t carry) {
+#ifdef __x86_64__
+  unsigned char flag = static_cast<unsigned char>(carry);
+  for (size_t i = 0; i < size; ++i) {
+    unsigned long long sum;  // NOLINT(runtime/int)
+    flag = _addcarry_u64(flag, a[i], b[i], &sum);
+    out[i] = sum;
+  }
+  return flag;
+#else
+  for (size_t i = 0; i < size; ++i) {
+    UInt128 sum = static_cast<UInt128>(a[i]) + b[i] + carry;
+    out[i] = static_cast<uint64_t>(sum);
+    carry = static_cast<uint64_t>(sum >> 64);
+  }
+  return carry;
+#endif
+}
+
+// out = a - b - borrow over size limbs; returns the borrow out. out may alias a or b.
+uint64_t SubtractBorrowLimbs(uint64_t* out, const uint64_t* a, const uint64_t* b, size_t size, uint64_t borrow) {
+#ifdef __x86_64__
+  unsigned char flag = static_cast<unsigned char>(borrow);
+  for (size_t i = 0; i < size; ++i) {
+    unsigned long long difference;  // NOLINT(runtime/int)
+    flag = _subborrow_u64(flag, a[i], b[i], &difference);
+    out[i] = difference;
+  }
+  return flag;
+#else
+  for (size_t i = 0; i < size; ++i) {
+    UInt128 difference = static_cast<UInt128>(a[i]) - b[i] - borrow;
+    out[i] = static_cast<uint64_t>(difference);
+    borrow = static_cast<uint64_t>(difference >> 64) & 1;
+  }
+  return borrow;
+#endif
+}
+
+uint64_t DivideLimbsByNative(uint64_t* limbs, size_t size, uint64_t divisor) {
+  uint64_t remainder = 0;
+  for (size_t i = size; i-- > 0;) {
+    UInt128 current = static_cast<UInt128>(remainder) << 64 | limbs[i];
+    limbs[i] = static_cast<uint64_t>(current / divisor);
+    remainder = static_cast<uint64_t>(current % divisor);
+  }
+  return remainder;
+}
+
+// Bounds on the decimal length of a value with the given (non-zero) bit length; the two
+// constants bracket log10(2).
+size_t MinDecimalDigits(size_t bits) {
+  return static_cast<size_t>(static_cast<UInt128>(bits - 1) * 301029995663981 / 1000000000000000) + 1;
+}
+
+size_t MaxDecimalDigits(size_t bits) {
+  return static_cast<size_t>(static_cast<UInt128>(bits) * 301029995663982 / 1000000000000000) + 1;
+}
+
+// Runs the MULX/ADX kernel over the leading multiple of 4 of size limbs when the CPU has it; returns
+// the number of limbs done and updates carry.
+size_t MultiplyAccumulateBlocks(uint64_t* target, const uint64_t* source, size_t size, uint64_t factor,
+                                uint64_t& carry) {
+  const auto kernel = size >= kAdxLimbs ? ActiveKernels().multiply_accumulate : nullptr;
+  if (kernel != nullptr) {
+    size_t blocks = size / 4 * 4;
+    carry = kernel(target, source, blocks, factor, carry);
+    return blocks;
+  }
+  return 0;
+}
+
+// target += source * factor over size limbs; returns the limb carried out of the top. This is the
+// row kernel of the schoolbook products that every multiplication tier bottoms out in.
+uint64_t MultiplyAccumulateLimbs(uint64_t* target, const uint64_t* source, size_t size, uint64_t factor) {
+  uint64_t carry = 0;
+  for (size_t i = MultiplyAccumulateBlocks(target, source, size, factor, carry); i < size; ++i) {
+    UInt128 product = static_cast<UInt128>(source[i]) * factor + target[i] + carry;
+    target[i] = static_cast<uint64_t>(product);
+    carry = static_cast<uint64_t>(product >> 64);
+  }
+  return carry;
+}
+
+int ExponentWindow(size_t bits) {
+  return bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : bits > 1 ? 2 : 1;
+}
+
+// Left-to-right sliding-window exponentiation. multiply(x, y, out) stores the reduced product x * y
+// in out, which never aliases x or y; only odd powers of the base are precomputed.
+template <class Element, class Multiply>
+Element SlidingWindowPower(const Element& base, const Element& one, const uint64_t* exponent, size_t size,
+                           Multiply multiply) {
+  auto bit = [exponent](size_t index) { return (exponent[index / 64] >> (index % 64) & 1) != 0; };
+  size_t bits = size == 0 ? 0 : size * 64 - __builtin_clzll(exponent[size - 1]);
+  const int window = ExponentWindow(bits);
+
+  // table[i] = base^(2i + 1)
+  std::vector<Element> table(size_t{1} << (window - 1), base);
+  Element scratch = one;
+  if (table.size() > 1) {
+    Element square = one;
+    multiply(base, base, square);
+    for (size_t i = 1; i < table.size(); ++i) {
+      multiply(table[i - 1], square, table[i]);
+    }
+  }
+
+  Element result = one;
+  bool started = false;
+  for (size_t i = bits; i-- > 0;) {
+    if (!bit(i)) {
+      multiply(result, result, scratch);
+      std::swap(result, scratch);
+      continue;
+    }
+
+    // The longest window of at most `window` bits that ends in a set bit.
+    size_t low = i + 1 >= static_cast<size_t>(window) ? i + 1 - window : 0;
+    while (!bit(low)) {
+      ++low;
+    }
+    size_t value = 0;
+    for (size_t j = i + 1; j-- > low;) {
+      value = value << 1 | bit(j);
+      if (started) {
+        multiply(result, result, scratch);
+        std::swap(result, scratch);
+      }
+    }
+    if (started) {
+      multiply(result, table[value >> 1], scratch);
+      std::swap(result, scratch);
+    } else {
+      result = table[value >> 1];
+      started = true;
+    }
+    i = low;
+  }
+  return result;
+}
+
+// Moduli of the perfect-square filter. The low limb gives the residue modulo 256; the others divide
+// 2^48 - 1, so one Residue48 pass over the limbs serves all of them.
+constexpr uint32_t kSquareFilterModuli[] = {256, 63, 65, 17, 97, 241, 257, 673};
+
+// Bit r is set for every square residue r modulo the given modulus (at most 704).
+constexpr std::array<uint64_t, 11> SquareResidues(uint32_t modulus) {
+  std::array<uint64_t, 11> bits{};
+  for (uint32_t x = 0; x < modulus; ++x) {
+    uint32_t r = x * x % modulus;
+    bits[r / 64] |= uint64_t{1} << (r % 64);
+  }
+  return bits;
+}
+
+constexpr std::array<uint64_t, 11> kSquareResidues[] = {
+    SquareResidues(256), SquareResidues(63),  SquareResidues(65),  SquareResidues(17),
+    SquareResidues(97),  SquareResidues(241), SquareResidues(257), SquareResidues(673)};
+
+bool IsSquareResidue(uint64_t residue, size_t filter) {
+  return (kSquareResidues[filter][residue / 64] >> (residue % 64) & 1) != 0;
+}
+
+// The value of the limbs modulo 2^48 - 1: limb i is worth 2^(64 * i) = 2^(16 * (i mod 3)) there.
+uint64_t Residue48(const uint64_t* limbs, size_t size) {
+  constexpr uint64_t kMask = (uint64_t{1} << 48) - 1;
+  UInt128 sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    UInt128 term = static_cast<UInt128>(limbs[i]) << (16 * (i % 3));
+    sum += (term & kMask) + (term >> 48);
+  }
+  while (sum > kMask) {
+    sum = (sum & kMask) + (sum >> 48);
+  }
+  return static_cast<uint64_t>(sum);
+}
+
+// Applies op limb by limb to two sign-magnitude values in their two's complement form, sign extension
+// included, and stores the result as a magnitude in result, which may alias a or b and must have room
+// for max(a_size, b_size) + 1 limbs. Returns whether the result is negative.
+template <class Op>
+bool CombineBits(const uint64_t* a, size_t a_size, bool a_negative, const uint64_t* b, size_t b_size,
+                 bool b_negative, uint64_t* result, Op op) {
+  const bool negative = op(a_negative ? ~uint64_t{0} : 0, b_negative ? ~uint64_t{0} : 0) != 0;
+  // -m = ~m + 1, with the + 1 carried up through the limbs.
+  bool a_carry = a_negative;
+  bool b_carry = b_negative;
+  bool carry = negative;
+  const size_t size = std::max(a_size, b_size) + 1;
+  for (size_t i = 0; i < size; ++i) {
+    uint64_t x = i < a_size ? a[i] : 0;
+    uint64_t y = i < b_size ? b[i] : 0;
+    if (a_negative) {
+      x = ~x + a_carry;
+      a_carry = a_carry && x == 0;
+    }
+    if (b_negative) {
+      y = ~y + b_carry;
+      b_carry = b_carry && y == 0;
+    }
+    uint64_t z = op(x, y);
+    if (negative) {
+      z = ~z + carry;
+      carry = carry && z == 0;
+    }
+    result[i] = z;
+  }
+  return negative;
+}
+
+constexpr int kLeadingGcdBits = 62;
+
+// (a, b) -> (m00 * a + m01 * b, m10 * a + m11 * b) for a run of Euclid steps.
+struct Cofactors {
+  int64_t m00 = 1;
+  int64_t m01 = 0;
+  int64_t m10 = 0;
+  int64_t m11 = 1;
+};
+
+// Simulates Euclid on the leading bits a_high >= b_high of two values that share a shift, in the
+// form of Knuth, TAOCP vol. 2, 4.5.2, Algorithm L: a step is only taken while both quotient bounds
+// agree and the new remainder is provably at least floor >= 1 in units of the shift.
+Cofactors LeadingEuclid(int64_t a_high, int64_t b_high, int64_t floor) {
+  Cofactors m;
+  if (b_high < floor) {
+    return m;
+  }
+  while (true) {
+    int64_t q = (a_high + m.m00) / (b_high + m.m10);
+    if (q != (a_high + m.m01) / (b_high + m.m11)) {
+      break;
+    }
+    int64_t m10 = m.m00 - q * m.m10;
+    int64_t m11 = m.m01 - q * m.m11;
+    int64_t remainder = a_high - q * b_high;
+    if (remainder + std::min(m10, m11) < floor) {
+      break;
+    }
+    m = {m.m10, m.m11, m10, m11};
+    a_high = b_high;
+    b_high = remainder;
+  }
+  return m;
+}
+
+// Primes up to limit by an odd-only sieve of Eratosthenes.
+std::vector<uint64_t> PrimesUpTo(uint64_t limit) {
+  std::vector<uint64_t> primes;
+  if (limit < 2) {
+    return primes;
+  }
+  primes.push_back(2);
+  std::vector<bool> composite((limit - 1) / 2);  // entry i stands for 2 * i + 3
+  for (size_t i = 0; i < composite.size(); ++i) {
+    if (composite[i]) {
+      continue;
+    }
+    const uint64_t p = 2 * i + 3;
+    primes.push_back(p);
+    for (uint64_t j = (p * p - 3) / 2; j < composite.size(); j += p) {
+      composite[j] = true;
+    }
+  }
+  return primes;
+}
+
+// Natural log of a lower bound on lo * (lo + 1) * ... * hi for 1 <= lo <= hi: the upper half of
+// the range alone, so the estimate never cancels for huge lo.
+double LogRangeLowerBound(uint64_t lo, uint64_t hi) {
+  const uint64_t half = (hi - lo) / 2;
+  return static_cast<double>(hi - lo + 1 - half) * std::log(static_cast<double>(lo + half));
+}
+
+// True when a value whose natural log is at least log_value certainly has more than limit decimal
+// digits. Lets the product-tree functions fail before sieving or multiplying anything.
+bool ExceedsDigits(double log_value, size_t limit) {
+  return log_value / std::log(10.0) > static_cast<double>(limit) * (1 + 1e-9) + 1;
+}
+
+// The odd prime powers of n! / ((n / 2)!)^2: p^e with e the number of odd floor(n / p^i), which
+// keeps every p^e <= n.
+void OddSwingFactors(uint64_t n, const std::vector<uint64_t>& primes, std::vector<uint64_t>& factors) {
+  factors.clear();
+  for (size_t i = 1; i < primes.size() && primes[i] <= n; ++i) {
+    const uint64_t p = primes[i];
+    uint64_t power = 1;
+    for (uint64_t q = n / p; q != 0; q /= p) {
+      if (q & 1) {
+        power *= p;
+      }
+    }
+    if (power != 1) {
+      factors.push_back(power);
+    }
+  }
+}
+
+struct OperationCounters {
+  std::atomic<uint64_t> calls;
+  std::atomic<uint64_t> limbs;
+  std::atomic<uint64_t> allocations;
+  std::atomic<uint64_t> nanoseconds;
+  std::array<std::atomic<uint64_t>, BigInteger::kTierCount> tiers;
+  std::array<std::atomic<uint64_t>, BigInteger::kSizeBuckets> sizes;
+};
+
+// Statistics of all threads, updated with relaxed increments.
+std::array<OperationCounters, BigInteger::kOperationCount> operation_counters;
+
+size_t SizeBucket(size_t limbs) {
+  size_t bucket = limbs == 0 ? 0 : 64 - __builtin_clzll(limbs);
+  return std::min(bucket, BigInteger::kSizeBuckets - 1);
+}
+
+// The statistics tier of a multiplication algorithm other than kAuto.
+BigInteger::Tier MultiplyTier(BigInteger::MultiplyAlgorithm algorithm) {
+  return static_cast<BigInteger::Tier>(static_cast<int>(algorithm) - 1);
+}
+
+// Records one operation when it goes out of scope, with the time and the limb buffer allocations of
+// the calling thread since it was created, unless it is nested in another scope. Without
+// BIG_INTEGER_STATISTICS it does nothing.
+class OperationScope {
+ public:
+  OperationScope(BigInteger::Operation operation, size_t limbs, BigInteger::Tier tier = BigInteger::Tier::kBasecase)
+      : operation_(operation), limbs_(limbs), tier_(tier) {
+    if constexpr (kBigIntegerStatistics) {
+      outermost_ = operation_depth++ == 0;
+      if (outermost_) {
+        allocations_ = small_buffer_allocations;
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+  }
+
+  OperationScope(const OperationScope&) = delete;
+  OperationScope& operator=(const OperationScope&) = delete;
+
+  ~OperationScope() {
+    if constexpr (kBigIntegerStatistics) {
+      --operation_depth;
+      if (!outermost_) {
+        return;
+      }
+      auto nanoseconds =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count();
+      auto& counters = operation_counters[static_cast<size_t>(operation_)];
+      counters.calls.fetch_add(1, std::memory_order_relaxed);
+      counters.limbs.fetch_add(limbs_, std::memory_order_relaxed);
+      counters.allocations.fetch_add(small_buffer_allocations - allocations_, std::memory_order_relaxed);
+      counters.nanoseconds.fetch_add(static_cast<uint64_t>(nanoseconds), std::memory_order_relaxed);
+      counters.tiers[static_cast<size_t>(tier_)].fetch_add(1, std::memory_order_relaxed);
+      counters.sizes[SizeBucket(limbs_)].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  void SetTier(BigInteger::Tier tier) {
+    tier_ = tier;
+  }
+
+ private:
+  BigInteger::Operation operation_;
+  size_t limbs_;
+  BigInteger::Tier tier_;
+  bool outermost_ = false;
+  uint64_t allocations_ = 0;
+  std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace
+
+void CountSmallBufferAllocation() {
+  ++small_buffer_allocations;
+}
+
+BigInteger::BigInteger() : is_negative_(false) {
+}
+
+BigInteger::BigInteger(int value) : is_negative_(value < 0) {
+  AddLimb(MagnitudeOf(value));
+}
+
+BigInteger::BigInteger(int64_t value) : is_negative_(value < 0) {
+  AddLimb(MagnitudeOf(value));
+}
+
+BigInteger::BigInteger(const std::string& value) {
+  ParseString(value);
+}
+
+BigInteger::BigInteger(const char* value) {
+  ParseString(std::string(value));
+}
+
+void BigInteger::AddLimb(uint64_t value) {
+  if (value != 0) {
+    limbs_.PushBack(value);
+  }
+}
+
+void BigInteger::ParseString(const std::string& str) {
+  OperationScope scope(Operation::kParse, (str.length() + kDecimalBaseDigits - 1) / kDecimalBaseDigits);
+  is_negative_ = false;
+  limbs_.Clear();
+
+  size_t start = 0;
+  if (str[0] == '-') {
+    is_negative_ = true;
+    start = 1;
+  } else if (str[0] == '+') {
+    start = 1;
+  }
+
+  // Split the text into kDecimalBaseDigits-digit chunks, least significant first.
+  std::vector<Limb> chunks;
+  chunks.reserve((str.length() - start) / kDecimalBaseDigits + 1);
+  for (size_t end = str.length(); end > start;) {
+    size_t begin = end - start > kDecimalBaseDigits ? end - kDecimalBaseDigits : start;
+    Limb chunk = 0;
+    bool invalid = false;
+    for (size_t j = begin; j < end; ++j) {
+      Limb digit = static_cast<unsigned char>(str[j]) - Limb{'0'};
+      invalid |= digit > 9;
+      chunk = chunk * 10 + digit;
+    }
+    if constexpr (kBigIntegerChecked) {
+      if (invalid) {
+        throw BigIntegerOverflow();
+      }
+    }
+    chunks.push_back(chunk);
+    end = begin;
+  }
+
+  if (chunks.size() <= kDecimalThreshold) {
+    for (size_t i = chunks.size(); i-- > 0;) {
+      AddLimb(MultiplyAddLimbs(limbs_.Data(), limbs_.Size(), kDecimalBase, chunks[i]));
+    }
+  } else {
+    scope.SetTier(Tier::kSubquadratic);
+    // powers[k] = kDecimalBase^(2^k), for every 2^k below the chunk count.
+    std::vector<BigInteger> powers(1);
+    powers[0].limbs_.PushBack(kDecimalBase);
+    while ((size_t{1} << powers.size()) < chunks.size()) {
+      powers.push_back(MultiplyParts(powers.back(), powers.back()));
+    }
+    limbs_ = ParseDecimal(chunks.data(), chunks.size(), powers).limbs_;
+  }
+
+  Normalize();
+}
+
+// Subquadratic conversion: the chunks are split at the largest power of two below their count,
+// so that the high half is scaled by one of the precomputed powers.
+BigInteger BigInteger::ParseDecimal(const Limb* chunks, size_t count, const std::vector<BigInteger>& powers) {
+  BigInteger result;
+  if (count <= kDecimalThreshold) {
+    for (size_t i = count; i-- > 0;) {
+      result.AddLimb(MultiplyAddLimbs(result.limbs_.Data(), result.limbs_.Size(), kDecimalBase, chunks[i]));
+    }
+    return result;
+  }
+
+  size_t level = 0;
+  while ((size_t{2} << level) < count) {
+    ++level;
+  }
+  size_t half = size_t{1} << level;
+  result = MultiplyParts(ParseDecimal(chunks + half, count - half, powers), powers[level]);
+  result += ParseDecimal(chunks, half, powers);
+  return result;
+}
+
+void BigInteger::Normalize() {
+  RemoveLeadingZeros();
+  if (limbs_.Empty()) {
+    is_negative_ = false;
+  }
+}
+
+void BigInteger::RemoveLeadingZeros() {
+  while (!limbs_.Empty() && limbs_.Back() == 0) {
+    limbs_.PopBack();
+  }
+}
+
+void BigInteger::CheckDivision(const BigInteger& divisor) const {
+  if (divisor.limbs_.Empty()) {
+    throw BigIntegerDivisionByZero();
+  }
+}
+
+bool BigInteger::IsNegative() const {
+  return is_negative_;
+}
+
+BigInteger BigInteger::Absolute() const {
+  BigInteger result = *this;
+  result.is_negative_ = false;
+  return result;
+}
+
+BigInteger BigInteger::operator+() const {
+  return *this;
+}
+
+BigInteger BigInteger::operator-() const {
+  BigInteger result = *this;
+  result.is_negative_ = !is_negative_;
+  result.Normalize();
+  return result;
+}
+
+BigInteger& BigInteger::operator+=(const BigInteger& other) {
+  OperationScope scope(Operation::kAdd, std::max(limbs_.Size(), other.limbs_.Size()));
+  AddSigned(other, other.is_negative_);
+  return *this;
+}
+
+BigInteger& BigInteger::operator-=(const BigInteger& other) {
+  OperationScope scope(Operation::kSubtract, std::max(limbs_.Size(), other.limbs_.Size()));
+  AddSigned(other, !other.is_negative_);
+  return *this;
+}
+
+// Adds (-1)^other_negative * |other| in place; other may alias *this.
+void BigInteger::AddSigned(const BigInteger& other, bool other_negative) {
+  if (other.limbs_.Empty()) {
+    return;
+  }
+
+  if (limbs_.Empty() || is_negative_ == other_negative) {
+    // Grow only for a carry out of the top limb, so that sums which still fit stay inline.
+    is_negative_ = other_negative;
+    size_t size = std::max(limbs_.Size(), other.limbs_.Size());
+    limbs_.Resize(size, 0);
+    AddLimb(AddLimbs(limbs_.Data(), size, other.limbs_.Data(), other.limbs_.Size()));
+  } else if (CompareLimbs(limbs_.Data(), limbs_.Size(), other.limbs_.Data(), other.limbs_.Size()) >= 0) {
+    SubtractLimbs(limbs_.Data(), limbs_.Size(), other.limbs_.Data(), other.limbs_.Size());
+  } else {
+    limbs_.Resize(other.limbs_.Size(), 0);
+    ReverseSubtractLimbs(limbs_.Data(), other.limbs_.Data(), other.limbs_.Size());
+    is_negative_ = other_negative;
+  }
+
+  Normalize();
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& other) {
+  BigInteger result;
+  MultiplyHelper(*this, other, result);
+  *this = std::move(result);
+  return *this;
+}
+
+void BigInteger::MultiplyHelper(const BigInteger& a, const BigInteger& b, BigInteger& result,
+                                MultiplyAlgorithm algorithm) {
+  if (kBigIntegerChecked && a && b && MinDecimalDigits(a.BitLength() + b.BitLength() - 1) > max_digit_count_) {
+    throw BigIntegerOverflow();
+  }
+
+  const Limb* lhs = a.limbs_.Data();
+  const Limb* rhs = b.limbs_.Data();
+  size_t lhs_size = a.limbs_.Size();
+  size_t rhs_size = b.limbs_.Size();
+  if (lhs_size < rhs_size) {
+    std::swap(lhs, rhs);
+    std::swap(lhs_size, rhs_size);
+  }
+  if (algorithm == MultiplyAlgorithm::kAuto) {
+    algorithm = rhs_size != 0 ? SelectMultiplyAlgorithm(lhs_size, rhs_size) : MultiplyAlgorithm::kSchoolbook;
+  }
+  OperationScope scope(&a == &b ? Operation::kSquare : Operation::kMultiply, lhs_size, MultiplyTier(algorithm));
+
+  result.limbs_.Assign(lhs_size + rhs_size, 0);
+  result.is_negative_ = a.is_negative_ != b.is_negative_;
+
+  if (rhs_size != 0) {
+    MultiplyWith(algorithm, lhs, lhs_size, rhs, rhs_size, result.limbs_.Data());
+  }
+
+  result.Normalize();
+
+  if (kBigIntegerChecked && result.ExceedsDigitCount(max_digit_count_)) {
+    throw BigIntegerOverflow();
+  }
+}
+
+// The tier kAuto selects for a_size >= b_size >= 1 limbs.
+BigInteger::MultiplyAlgorithm BigInteger::SelectMultiplyAlgorithm(size_t a_size, size_t b_size) {
+  if (b_size < karatsuba_threshold_) {
+    return MultiplyAlgorithm::kSchoolbook;
+  } else if (b_size >= ntt_threshold_) {
+    return MultiplyAlgorithm::kNtt;
+  } else if (a_size >= 2 * b_size) {
+    return MultiplyAlgorithm::kKaratsuba;
+  } else if (b_size >= toom4_threshold_) {
+    return MultiplyAlgorithm::kToom4;
+  } else if (b_size >= toom3_threshold_) {
+    return MultiplyAlgorithm::kToom3;
+  }
+  return MultiplyAlgorithm::kKaratsuba;
+}
+
+// All limb-level multiplication routines expect a_size >= b_size >= 1 and accumulate
+// the product into a zero-filled buffer of a_size + b_size limbs.
+void BigInteger::MultiplyWith(MultiplyAlgorithm algorithm, const Limb* a, size_t a_size, const Limb* b,
+                              size_t b_size, Limb* result) {
+  switch (algorithm) {
+    case MultiplyAlgorithm::kKaratsuba:
+      KaratsubaMultiply(a, a_size, b, b_size, result);
+      break;
+    case MultiplyAlgorithm::kToom3:
+      Toom3Multiply(a, a_size, b, b_size, result);
+      break;
+    case MultiplyAlgorithm::kToom4:
+      Toom4Multiply(a, a_size, b, b_size, result);
+      break;
+    case MultiplyAlgorithm::kNtt:
+      NttMultiply(a, a_size, b, b_size, result);
+      break;
+    default:
+      SchoolbookMultiply(a, a_size, b, b_size, result);
+      break;
+  }
+}
+
+void BigInteger::MultiplyLimbs(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result) {
+  MultiplyWith(SelectMultiplyAlgorithm(a_size, b_size), a, a_size, b, b_size, result);
+}
+
+void BigInteger::SchoolbookMultiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result) {
+  if (a == b && a_size == b_size) {
+    SchoolbookSquare(a, a_size, result);
+    return;
+  }
+  // Long rows go through the row kernel, one per limb of the shorter operand; short ones stay inline.
+  if (a_size >= kAdxLimbs) {
+    for (size_t i = 0; i < b_size; ++i) {
+      result[i + a_size] = MultiplyAccumulateLimbs(result + i, a, a_size, b[i]);
+    }
+    return;
+  }
+  for (size_t i = 0; i < a_size; ++i) {
+    Limb carry = 0;
+    for (size_t j = 0; j < b_size; ++j) {
+      UInt128 product = static_cast<UInt128>(a[i]) * b[j] + result[i + j] + carry;
+      result[i + j] = static_cast<Limb>(product);
+      carry = static_cast<Limb>(product >> kLimbBits);
+    }
+    result[i + b_size] = carry;
+  }
+}
+
+// Each off-diagonal product a[i] * a[j] is computed once and doubled, then the squares on the
+// diagonal are added.
+void BigInteger::SchoolbookSquare(const Limb* a, size_t size, Limb* result) {
+  for (size_t i = 0; i + 1 < size; ++i) {
+    if (size - i - 1 >= kAdxLimbs) {
+      result[i + size] = MultiplyAccumulateLimbs(result + 2 * i + 1, a + i + 1, size - i - 1, a[i]);
+      continue;
+    }
+    Limb carry = 0;
+    for (size_t j = i + 1; j < size; ++j) {
+      UInt128 product = static_cast<UInt128>(a[i]) * a[j] + result[i + j] + carry;
+      result[i + j] = static_cast<Limb>(product);
+      carry = static_cast<Limb>(product >> kLimbBits);
+    }
+    result[i + size] = carry;
+  }
+
+  Limb shifted_out = 0;
+  Limb carry = 0;
+  for (size_t i = 0; i < size; ++i) {
+    UInt128 square = static_cast<UInt128>(a[i]) * a[i];
+    Limb low = result[2 * i];
+    Limb high = result[2 * i + 1];
+    UInt128 sum = static_cast<UInt128>(low << 1 | shifted_out) + static_cast<Limb>(square) + carry;
+    result[2 * i] = static_cast<Limb>(sum);
+    sum = static_cast<UInt128>(high << 1 | low >> (kLimbBits - 1)) + static_cast<Limb>(square >> kLimbBits) +
+          static_cast<Limb>(sum >> kLimbBits);
+    result[2 * i + 1] = static_cast<Limb>(sum);
+    carry = static_cast<Limb>(sum >> kLimbBits);
+    shifted_out = high >> (kLimbBits - 1);
+  }
+}
+
+void BigInteger::KaratsubaMultiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result) {
+  // Below four limbs the half-sums are as long as the operands and the recursion would not shrink.
+  if (b_size < 2 || a_size < 4) {
+    SchoolbookMultiply(a, a_size, b, b_size, result);
+    return;
+  }
+
+  // Unbalanced operands: cut the longer one into b_size-limb slices so that each
+  // sub-product is balanced.
+  if (a_size >= 2 * b_size) {
+    std::vector<Limb> slice(2 * b_size);
+    for (size_t offset = 0; offset < a_size; offset += b_size) {
+      size_t length = std::min(b_size, a_size - offset);
+      std::fill(slice.begin(), slice.end(), 0);
+      MultiplyLimbs(b, b_size, a + offset, length, slice.data());
+      AddLimbs(result + offset, a_size + b_size - offset, slice.data(), length + b_size);
+    }
+    return;
+  }
+
+  // a = a1 * B^half + a0, b = b1 * B^half + b0, and b_size > half holds since a_size < 2 * b_size.
+  size_t half = a_size / 2;
+  const Limb* a_high = a + half;
+  const Limb* b_high = b + half;
+  size_t a_high_size = a_size - half;
+  size_t b_high_size = b_size - half;
+
+  MultiplyLimbs(a, half, b, half, result);
+  if (a_high_size >= b_high_size) {
+    MultiplyLimbs(a_high, a_high_size, b_high, b_high_size, result + 2 * half);
+  } else {
+    MultiplyLimbs(b_high, b_high_size, a_high, a_high_size, result + 2 * half);
+  }
+
+  std::vector<Limb> a_sum(a_high, a_high + a_high_size);
+  a_sum.push_back(0);
+  AddLimbs(a_sum.data(), a_sum.size(), a, half);
+
+  // middle = (a0 + a1) * (b0 + b1) - a0 * b0 - a1 * b1; when squaring both sums coincide.
+  std::vector<Limb> middle;
+  if (a == b && a_size == b_size) {
+    middle.assign(2 * a_sum.size(), 0);
+    MultiplyLimbs(a_sum.data(), a_sum.size(), a_sum.data(), a_sum.size(), middle.data());
+  } else {
+    std::vector<Limb> b_sum(half + 1, 0);
+    std::copy(b, b + half, b_sum.begin());
+    if (b_high_size > half) {
+      b_sum.resize(b_high_size + 1, 0);
+    }
+    AddLimbs(b_sum.data(), b_sum.size(), b_high, b_high_size);
+
+    middle.assign(a_sum.size() + b_sum.size(), 0);
+    if (a_sum.size() >= b_sum.size()) {
+      MultiplyLimbs(a_sum.data(), a_sum.size(), b_sum.data(), b_sum.size(), middle.data());
+    } else {
+      MultiplyLimbs(b_sum.data(), b_sum.size(), a_sum.data(), a_sum.size(), middle.data());
+    }
+  }
+  SubtractLimbs(middle.data(), middle.size(), result, 2 * half);
+  SubtractLimbs(middle.data(), middle.size(), result + 2 * half, a_high_size + b_high_size);
+
+  size_t middle_size = middle.size();
+  while (middle_size > 0 && middle[middle_size - 1] == 0) {
+    --middle_size;
+  }
+  AddLimbs(result + half, a_size + b_size - half, middle.data(), middle_size);
+}
+
+// Both require source_size <= target_size; a borrow out of the top limb is dropped, and AddLimbs
+// returns the carry out of it.
+BigInteger::Limb BigInteger::AddLimbs(Limb* target, size_t target_size, const Limb* source, size_t source_size) {
+  Limb carry = 0;
+  size_t i = AddBlocks<false>(target, target, source, source_size, carry);
+  carry = AddCarryLimbs(target + i, target + i, source + i, source_size - i, carry);
+  for (i = source_size; i < target_size && carry != 0; ++i) {
+    carry = ++target[i] == 0;
+  }
+  return carry;
+}
+
+void BigInteger::SubtractLimbs(Limb* target, size_t target_size, const Limb* source, size_t source_size) {
+  Limb borrow = 0;
+  size_t i = AddBlocks<true>(target, target, source, source_size, borrow);
+  borrow = SubtractBorrowLimbs(target + i, target + i, source + i, source_size - i, borrow);
+  for (i = source_size; i < target_size && borrow != 0; ++i) {
+    borrow = target[i]-- == 0;
+  }
+}
+
+// target = source - target over size limbs; requires source >= target.
+void BigInteger::ReverseSubtractLimbs(Limb* target, const Limb* source, size_t size) {
+  Limb borrow = 0;
+  size_t i = AddBlocks<true>(target, source, target, size, borrow);
+  SubtractBorrowLimbs(target + i, source + i, target + i, size - i, borrow);
+}
+
+// Toom-Cook tiers work on BigInteger pieces: evaluation and interpolation are linear-time,
+// so the signed intermediate values are cheaper to express with the regular operators.
+void BigInteger::Toom3Multiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result) {
+  if (b_size < 6 || a_size >= 2 * b_size) {
+    KaratsubaMultiply(a, a_size, b, b_size, result);
+    return;
+  }
+
+  size_t part = (a_size + 2) / 3;
+  BigInteger lhs[5];
+  BigInteger rhs[5];
+  auto evaluate = [part](const Limb* limbs, size_t size, BigInteger* values) {
+    BigInteger x0 = SliceLimbs(limbs, size, 0, part);
+    BigInteger x1 = SliceLimbs(limbs, size, part, part);
+    BigInteger x2 = SliceLimbs(limbs, size, 2 * part, part);
+
+    // Points 0, 1, -1, -2, infinity.
+    BigInteger even = x0 + x2;
+    values[0] = x0;
+    values[1] = even + x1;
+    values[2] = even - x1;
+    values[3] = values[2] + x2;
+    values[3] += values[3];
+    values[3] -= x0;
+    values[4] = x2;
+  };
+  // Squaring evaluates once and squares the point values.
+  const bool square = a == b && a_size == b_size;
+  evaluate(a, a_size, lhs);
+  if (!square) {
+    evaluate(b, b_size, rhs);
+  }
+
+  BigInteger w[5];
+  RunTasks(5, b_size >= parallel_threshold_.load() ? multiply_threads_.load() : 1,
+           [&](size_t i) { w[i] = MultiplyParts(lhs[i], square ? lhs[i] : rhs[i]); });
+
+  // Bodrato's interpolation sequence.
+  BigInteger c3 = w[3] - w[1];
+  c3.DivideByNative(3);
+  BigInteger c1 = w[1] - w[2];
+  c1.DivideByNative(2);
+  BigInteger c2 = w[2] - w[0];
+  c3 = c2 - c3;
+  c3.DivideByNative(2);
+  c3 += w[4] + w[4];
+  c2 += c1 - w[4];
+  c1 -= c3;
+
+  size_t result_size = a_size + b_size;
+  AccumulateShifted(result, result_size, w[0], 0);
+  AccumulateShifted(result, result_size, c1, part);
+  AccumulateShifted(result, result_size, c2, 2 * part);
+  AccumulateShifted(result, result_size, c3, 3 * part);
+  AccumulateShifted(result, result_size, w[4], 4 * part);
+}
+
+void BigInteger::Toom4Multiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result) {
+  if (b_size < 8 || a_size >= 2 * b_size) {
+    Toom3Multiply(a, a_size, b, b_size, result);
+    return;
+  }
+
+  size_t part = (a_size + 3) / 4;
+  BigInteger lhs[7];
+  BigInteger rhs[7];
+  auto evaluate = [part](const Limb* limbs, size_t size, BigInteger* values) {
+    BigInteger x0 = SliceLimbs(limbs, size, 0, part);
+    BigInteger x1 = SliceLimbs(limbs, size, part, part);
+    BigInteger x2 = SliceLimbs(limbs, size, 2 * part, part);
+    BigInteger x3 = SliceLimbs(limbs, size, 3 * part, part);
+
+    // Points 0, 1, -1, 2, -2, 1/2 (scaled by 2^3), infinity.
+    BigInteger even = x0 + x2;
+    BigInteger odd = x1 + x3;
+    values[0] = x0;
+    values[1] = even + odd;
+    values[2] = even - odd;
+
+    BigInteger x2_times_4 = x2;
+    x2_times_4.MultiplyByNative(4);
+    BigInteger x3_times_4 = x3;
+    x3_times_4.MultiplyByNative(4);
+    even = x0 + x2_times_4;
+    odd = x1 + x3_times_4;
+    odd += odd;
+    values[3] = even + odd;
+    values[4] = even - odd;
+
+    BigInteger half = x0;
+    half.MultiplyByNative(2);
+    half += x1;
+    half.MultiplyByNative(2);
+    half += x2;
+    half.MultiplyByNative(2);
+    values[5] = half + x3;
+    values[6] = x3;
+  };
+  const bool square = a == b && a_size == b_size;
+  evaluate(a, a_size, lhs);
+  if (!square) {
+    evaluate(b, b_size, rhs);
+  }
+
+  BigInteger w[7];
+  RunTasks(7, b_size >= parallel_threshold_.load() ? multiply_threads_.load() : 1,
+           [&](size_t i) { w[i] = MultiplyParts(lhs[i], square ? lhs[i] : rhs[i]); });
+
+  const BigInteger& c0 = w[0];
+  const BigInteger& c6 = w[6];
+
+  BigInteger even1 = w[1] + w[2];
+  even1.DivideByNative(2);
+  even1 -= c0 + c6;
+  BigInteger odd1 = w[1] - w[2];
+  odd1.DivideByNative(2);
+
+  BigInteger scaled_c6 = c6;
+  scaled_c6.MultiplyByNative(64);
+  BigInteger even2 = w[3] + w[4];
+  even2.DivideByNative(2);
+  even2 -= c0 + scaled_c6;
+  even2.DivideByNative(4);
+  BigInteger odd2 = w[3] - w[4];
+  odd2.DivideByNative(4);
+
+  // even1 = c2 + c4, even2 = c2 + 4 * c4.
+  BigInteger c4 = even2 - even1;
+  c4.DivideByNative(3);
+  BigInteger c2 = even1 - c4;
+
+  // odd1 = c1 + c3 + c5, odd2 = c1 + 4 * c3 + 16 * c5, half = 16 * c1 + 4 * c3 + c5.
+  BigInteger half = w[5] - c6;
+  BigInteger scaled = c0;
+  scaled.MultiplyByNative(64);
+  half -= scaled;
+  scaled = c2;
+  scaled.MultiplyByNative(16);
+  half -= scaled;
+  scaled = c4;
+  scaled.MultiplyByNative(4);
+  half -= scaled;
+  half.DivideByNative(2);
+
+  BigInteger u = half - odd1;
+  u.DivideByNative(3);
+  BigInteger v = odd2 - odd1;
+  v.DivideByNative(3);
+
+  BigInteger c1 = u;
+  c1.MultiplyByNative(4);
+  c1 += v;
+  scaled = odd1;
+  scaled.MultiplyByNative(5);
+  c1 -= scaled;
+  c1.DivideByNative(15);
+
+  scaled = c1;
+  scaled.MultiplyByNative(5);
+  BigInteger c3 = u - scaled;
+  BigInteger c5 = odd1 - c1 - c3;
+
+  size_t result_size = a_size + b_size;
+  AccumulateShifted(result, result_size, c0, 0);
+  AccumulateShifted(result, result_size, c1, part);
+  AccumulateShifted(result, result_size, c2, 2 * part);
+  AccumulateShifted(result, result_size, c3, 3 * part);
+  AccumulateShifted(result, result_size, c4, 4 * part);
+  AccumulateShifted(result, result_size, c5, 5 * part);
+  AccumulateShifted(result, result_size, c6, 6 * part);
+}
+
+// Limbs are split into 32-bit pieces; with at most kMaxNttLength / 2 pieces in the shorter operand
+// every convolution coefficient stays below the product of the three primes.
+void BigInteger::NttMultiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result) {
+  constexpr int kPieceBits = 32;
+  constexpr size_t kPiecesPerLimb = kLimbBits / kPieceBits;
+  constexpr Limb kPieceMask = (Limb{1} << kPieceBits) - 1;
+
+  size_t pieces = (a_size + b_size) * kPiecesPerLimb;
+  size_t length = 1;
+  while (length < pieces) {
+    length <<= 1;
+  }
+  if (length > kMaxNttLength) {
+    Toom4Multiply(a, a_size, b, b_size, result);
+    return;
+  }
+
+  auto split = [](const Limb* limbs, size_t size) {
+    std::vector<uint32_t> values(size * kPiecesPerLimb);
+    for (size_t i = 0; i < values.size(); ++i) {
+      values[i] = static_cast<uint32_t>(limbs[i / kPiecesPerLimb] >> (i % kPiecesPerLimb * kPieceBits) & kPieceMask);
+    }
+    return values;
+  };
+  const bool square = a == b && a_size == b_size;
+  const std::vector<uint32_t> lhs = split(a, a_size);
+  const std::vector<uint32_t> rhs = square ? std::vector<uint32_t>() : split(b, b_size);
+
+  std::vector<uint32_t> residues[3];
+  RunTasks(3, b_size >= parallel_threshold_.load() ? multiply_threads_.load() : 1,
+           [&](size_t p) { residues[p] = ConvolveModulo(lhs, square ? lhs : rhs, length, kNttPrimes[p]); });
+
+  const uint64_t m0 = kNttPrimes[0];
+  const uint64_t m1 = kNttPrimes[1];
+  const uint64_t m2 = kNttPrimes[2];
+  const uint64_t m0_inverse_mod_m1 = PowerModulo(m0, m1 - 2, static_cast<uint32_t>(m1));
+  const uint64_t m01_inverse_mod_m2 = PowerModulo(m0 * m1 % m2, m2 - 2, static_cast<uint32_t>(m2));
+
+  // Garner's reconstruction; coefficients are below 2^85, so they and the carry fit in 128 bits.
+  UInt128 carry = 0;
+  for (size_t i = 0; i < pieces; ++i) {
+    uint64_t x0 = residues[0][i];
+    uint64_t x1 = (residues[1][i] + m1 - x0 % m1) % m1 * m0_inverse_mod_m1 % m1;
+    uint64_t x2 = (residues[2][i] + m2 - (x0 + m0 * x1) % m2) % m2 * m01_inverse_mod_m2 % m2;
+    carry += static_cast<UInt128>(m0 * m1) * x2 + m0 * x1 + x0;
+    result[i / kPiecesPerLimb] |= (static_cast<Limb>(carry) & kPieceMask) << (i % kPiecesPerLimb * kPieceBits);
+    carry >>= kPieceBits;
+  }
+}
+
+BigInteger BigInteger::MultiplyParts(const BigInteger& a, const BigInteger& b) {
+  BigInteger result;
+  result.limbs_.Assign(a.limbs_.Size() + b.limbs_.Size(), 0);
+  result.is_negative_ = a.is_negative_ != b.is_negative_;
+
+  if (!a.limbs_.Empty() && !b.limbs_.Empty()) {
+    if (a.limbs_.Size() >= b.limbs_.Size()) {
+      MultiplyLimbs(a.limbs_.Data(), a.limbs_.Size(), b.limbs_.Data(), b.limbs_.Size(), result.limbs_.Data());
+    } else {
+      MultiplyLimbs(b.limbs_.Data(), b.limbs_.Size(), a.limbs_.Data(), a.limbs_.Size(), result.limbs_.Data());
+    }
+  }
+
+  result.Normalize();
+  return result;
+}
+
+BigInteger BigInteger::SliceLimbs(const Limb* limbs, size_t size, size_t begin, size_t length) {
+  BigInteger result;
+  if (begin < size) {
+    result.limbs_.Assign(limbs + begin, limbs + std::min(size, begin + length));
+  }
+  result.Normalize();
+  return result;
+}
+
+void BigInteger::AccumulateShifted(Limb* target, size_t target_size, const BigInteger& value, size_t shift) {
+  if (!value.limbs_.Empty()) {
+    AddLimbs(target + shift, target_size - shift, value.limbs_.Data(), value.limbs_.Size());
+  }
+}
+
+BigInteger BigInteger::Multiply(const BigInteger& a, const BigInteger& b, MultiplyAlgorithm algorithm) {
+  BigInteger result;
+  MultiplyHelper(a, b, result, algorithm);
+  return result;
+}
+
+BigInteger BigInteger::Square(const BigInteger& value, MultiplyAlgorithm algorithm) {
+  BigInteger result;
+  MultiplyHelper(value, value, result, algorithm);
+  return result;
+}
+
+size_t BigInteger::MultiplyThreshold(MultiplyAlgorithm algorithm) {
+  switch (algorithm) {
+    case MultiplyAlgorithm::kKaratsuba:
+      return karatsuba_threshold_;
+    case MultiplyAlgorithm::kToom3:
+      return toom3_threshold_;
+    case MultiplyAlgorithm::kToom4:
+      return toom4_threshold_;
+    case MultiplyAlgorithm::kNtt:
+      return ntt_threshold_;
+    default:
+      return 0;
+  }
+}
+
+void BigInteger::SetMultiplyThreshold(MultiplyAlgorithm algorithm, size_t limbs) {
+  switch (algorithm) {
+    case MultiplyAlgorithm::kKaratsuba:
+      karatsuba_threshold_ = limbs;
+      break;
+    case MultiplyAlgorithm::kToom3:
+      toom3_threshold_ = limbs;
+      break;
+    case MultiplyAlgorithm::kToom4:
+      toom4_threshold_ = limbs;
+      break;
+    case MultiplyAlgorithm::kNtt:
+      ntt_threshold_ = limbs;
+      break;
+    default:
+      break;
+  }
+}
+
+size_t BigInteger::MaxDigitCount() {
+  return max_digit_count_;
+}
+
+void BigInteger::SetMaxDigitCount(size_t digits) {
+  max_digit_count_ = digits;
+}
+
+size_t BigInteger::DivideThreshold() {
+  return divide_threshold_;
+}
+
+void BigInteger::SetDivideThreshold(size_t limbs) {
+  divide_threshold_ = std::max<size_t>(limbs, 2);
+}
+
+size_t BigInteger::GcdThreshold() {
+  return gcd_threshold_;
+}
+
+void BigInteger::SetGcdThreshold(size_t limbs) {
+  gcd_threshold_ = std::max<size_t>(limbs, 4);
+}
+
+size_t BigInteger::MultiplyThreads() {
+  return multiply_threads_.load();
+}
+
+void BigInteger::SetMultiplyThreads(size_t threads) {
+  multiply_threads_.store(threads != 0 ? threads : std::max<size_t>(std::thread::hardware_concurrency(), 1));
+}
+
+size_t BigInteger::ParallelThreshold() {
+  return parallel_threshold_.load();
+}
+
+void BigInteger::SetParallelThreshold(size_t limbs) {
+  parallel_threshold_.store(std::max<size_t>(limbs, 1));
+}
+
+BigInteger::KernelSet BigInteger::Kernels() {
+  return ActiveKernels().set;
+}
+
+void BigInteger::SetKernels(KernelSet limit) {
+  active_kernels.store(KernelTable(limit), std::memory_order_release);
+}
+
+BigInteger::Statistics BigInteger::StatisticsSnapshot() {
+  Statistics statistics;
+  for (size_t i = 0; i < kOperationCount; ++i) {
+    const OperationCounters& counters = operation_counters[i];
+    OperationStatistics& snapshot = statistics[i];
+    snapshot.calls = counters.calls.load(std::memory_order_relaxed);
+    snapshot.limbs = counters.limbs.load(std::memory_order_relaxed);
+    snapshot.allocations = counters.allocations.load(std::memory_order_relaxed);
+    snapshot.nanoseconds = counters.nanoseconds.load(std::memory_order_relaxed);
+    for (size_t j = 0; j < kTierCount; ++j) {
+      snapshot.tiers[j] = counters.tiers[j].load(std::memory_order_relaxed);
+    }
+    for (size_t j = 0; j < kSizeBuckets; ++j) {
+      snapshot.sizes[j] = counters.sizes[j].load(std::memory_order_relaxed);
+    }
+  }
+  return statistics;
+}
+
+void BigInteger::ResetStatistics() {
+  for (OperationCounters& counters : operation_counters) {
+    counters.calls.store(0, std::memory_order_relaxed);
+    counters.limbs.store(0, std::memory_order_relaxed);
+    counters.allocations.store(0, std::memory_order_relaxed);
+    counters.nanoseconds.store(0, std::memory_order_relaxed);
+    for (auto& tier : counters.tiers) {
+      tier.store(0, std::memory_order_relaxed);
+    }
+    for (auto& bucket : counters.sizes) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+const char* BigInteger::OperationName(Operation operation) {
+  static constexpr const char* kNames[kOperationCount] = {"parse",    "print",  "add",     "subtract", "multiply",
+                                                          "square",   "divide", "compare", "increment"};
+  return kNames[static_cast<size_t>(operation)];
+}
+
+const char* BigInteger::TierName(Tier tier) {
+  static constexpr const char* kNames[kTierCount] = {"basecase", "karatsuba", "toom3",
+                                                     "toom4",    "ntt",       "subquadratic"};
+  return kNames[static_cast<size_t>(tier)];
+}
+
+BigInteger& BigInteger::operator/=(const BigInteger& other) {
+  BigInteger remainder;
+  return DivideWithRemainder(other, remainder);
+}
+
+BigInteger& BigInteger::operator%=(const BigInteger& other) {
+  BigInteger quotient;
+  DivMod(*this, other, quotient, *this);
+  return *this;
+}
+
+BigInteger& BigInteger::DivideWithRemainder(const BigInteger& divisor, BigInteger& remainder) {
+  DivMod(*this, divisor, *this, remainder);
+  return *this;
+}
+
+std::pair<BigInteger, BigInteger> BigInteger::DivMod(const BigInteger& dividend, const BigInteger& divisor) {
+  std::pair<BigInteger, BigInteger> result;
+  DivMod(dividend, divisor, result.first, result.second);
+  return result;
+}
+
+void BigInteger::DivMod(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                        BigInteger& remainder) {
+  dividend.CheckDivision(divisor);
+  if (&quotient == &dividend || &quotient == &divisor || &remainder == &dividend || &remainder == &divisor) {
+    BigInteger quotient_value;
+    BigInteger remainder_value;
+    DivideHelper(dividend, divisor, quotient_value, remainder_value);
+    quotient = std::move(quotient_value);
+    remainder = std::move(remainder_value);
+  } else {
+    DivideHelper(dividend, divisor, quotient, remainder);
+  }
+}
+
+void BigInteger::DivideHelper(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                              BigInteger& remainder) {
+  size_t dividend_size = dividend.limbs_.Size();
+  size_t divisor_size = divisor.limbs_.Size();
+  OperationScope scope(Operation::kDivide, std::max(dividend_size, divisor_size));
+  if (divisor_size >= divide_threshold_ && dividend_size >= divisor_size + divide_threshold_ / 2) {
+    scope.SetTier(Tier::kSubquadratic);
+    BurnikelZieglerDivide(dividend, divisor, quotient, remainder);
+  } else {
+    SchoolbookDivide(dividend, divisor, quotient, remainder);
+  }
+
+  quotient.is_negative_ = dividend.is_negative_ != divisor.is_negative_;
+  remainder.is_negative_ = dividend.is_negative_;
+
+  quotient.Normalize();
+  remainder.Normalize();
+}
+
+// Division helpers below only look at magnitudes and produce non-negative results.
+void BigInteger::SchoolbookDivide(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                                  BigInteger& remainder) {
+  int order = 0;
+  CompareDigits(dividend, divisor, order);
+
+  if (order < 0) {
+    quotient.limbs_.Clear();
+    remainder.limbs_ = dividend.limbs_;
+  } else if (divisor.limbs_.Size() == 1) {
+    quotient.limbs_ = dividend.limbs_;
+    remainder.limbs_.Clear();
+    remainder.AddLimb(quotient.DivideByNative(divisor.limbs_[0]));
+  } else {
+    size_t dividend_size = dividend.limbs_.Size();
+    size_t divisor_size = divisor.limbs_.Size();
+    quotient.limbs_.Assign(dividend_size - divisor_size + 1, 0);
+    remainder.limbs_.Assign(divisor_size, 0);
+    KnuthDivide(dividend.limbs_.Data(), dividend_size, divisor.limbs_.Data(), divisor_size,
+                quotient.limbs_.Data(), remainder.limbs_.Data());
+  }
+
+  quotient.is_negative_ = false;
+  remainder.is_negative_ = false;
+  quotient.Normalize();
+  remainder.Normalize();
+}
+
+// Burnikel, Ziegler, "Fast Recursive Division" (1998). The divisor is padded to size = j * 2^k limbs
+// and shifted so that the top bit of its top limb is set, then the dividend is consumed in blocks of
+// that size with the recursive 2n/1n division.
+void BigInteger::BurnikelZieglerDivide(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                                       BigInteger& remainder) {
+  size_t divisor_size = divisor.limbs_.Size();
+  size_t block_count = 1;
+  while (block_count * divide_threshold_ <= divisor_size) {
+    block_count <<= 1;
+  }
+  size_t size = (divisor_size + block_count - 1) / block_count * block_count;
+
+  const Limb scale = Limb{1} << __builtin_clzll(divisor.limbs_.Back());
+  BigInteger b = divisor.Absolute();
+  b.MultiplyByNative(scale);
+  b = ShiftLimbs(b, size - divisor_size);
+  BigInteger a = dividend.Absolute();
+  a.MultiplyByNative(scale);
+  a = ShiftLimbs(a, size - divisor_size);
+
+  // The top block is kept below the divisor so that every partial quotient fits in one block.
+  size_t blocks = std::max<size_t>(2, (a.limbs_.Size() + size) / size);
+  const Limb* limbs = a.limbs_.Data();
+  size_t limb_count = a.limbs_.Size();
+
+  BigInteger partial = ShiftLimbs(SliceLimbs(limbs, limb_count, (blocks - 1) * size, size), size);
+  partial += SliceLimbs(limbs, limb_count, (blocks - 2) * size, size);
+
+  quotient.limbs_.Assign((blocks - 1) * size, 0);
+  quotient.is_negative_ = false;
+  BigInteger block_quotient;
+  for (size_t i = blocks - 1; i-- > 0;) {
+    DivideTwoByOne(partial, b, size, block_quotient, remainder);
+    std::copy(block_quotient.limbs_.begin(), block_quotient.limbs_.end(), quotient.limbs_.begin() + i * size);
+    if (i > 0) {
+      partial = ShiftLimbs(remainder, size);
+      partial += SliceLimbs(limbs, limb_count, (i - 1) * size, size);
+    }
+  }
+  quotient.Normalize();
+
+  remainder = SliceLimbs(remainder.limbs_.Data(), remainder.limbs_.Size(), size - divisor_size,
+                         remainder.limbs_.Size());
+  remainder.DivideByNative(scale);
+}
+
+// Requires dividend < divisor * 2^(64 * size) and a normalized divisor of exactly size limbs.
+void BigInteger::DivideTwoByOne(const BigInteger& dividend, const BigInteger& divisor, size_t size,
+                                BigInteger& quotient, BigInteger& remainder) {
+  if (size % 2 != 0 || size < divide_threshold_) {
+    SchoolbookDivide(dividend, divisor, quotient, remainder);
+    return;
+  }
+
+  size_t half = size / 2;
+  const Limb* limbs = dividend.limbs_.Data();
+  size_t limb_count = dividend.limbs_.Size();
+
+  BigInteger high_quotient;
+  BigInteger partial;
+  DivideThreeByTwo(SliceLimbs(limbs, limb_count, half, limb_count), divisor, half, high_quotient, partial);
+  partial = ShiftLimbs(partial, half);
+  partial += SliceLimbs(limbs, limb_count, 0, half);
+  DivideThreeByTwo(partial, divisor, half, quotient, remainder);
+
+  quotient += ShiftLimbs(high_quotient, half);
+}
+
+// Divides a dividend of three size-limb blocks by a divisor of two such blocks, requiring
+// dividend < divisor * 2^(64 * size).
+void BigInteger::DivideThreeByTwo(const BigInteger& dividend, const BigInteger& divisor, size_t size,
+                                  BigInteger& quotient, BigInteger& remainder) {
+  const Limb* limbs = dividend.limbs_.Data();
+  size_t limb_count = dividend.limbs_.Size();
+  BigInteger divisor_high = SliceLimbs(divisor.limbs_.Data(), divisor.limbs_.Size(), size, size);
+  BigInteger divisor_low = SliceLimbs(divisor.limbs_.Data(), divisor.limbs_.Size(), 0, size);
+  BigInteger dividend_high = SliceLimbs(limbs, limb_count, size, limb_count);
+  BigInteger dividend_top = SliceLimbs(limbs, limb_count, 2 * size, limb_count);
+
+  BigInteger partial;
+  if (dividend_top < divisor_high) {
+    DivideTwoByOne(dividend_high, divisor_high, size, quotient, partial);
+  } else {
+    // The quotient estimate saturates at 2^(64 * size) - 1.
+    quotient.limbs_.Assign(size, ~Limb{0});
+    quotient.is_negative_ = false;
+    partial = dividend_high - ShiftLimbs(divisor_high, size) + divisor_high;
+  }
+
+  remainder = ShiftLimbs(partial, size);
+  remainder += SliceLimbs(limbs, limb_count, 0, size);
+  remainder -= MultiplyParts(quotient, divisor_low);
+  while (remainder.IsNegative()) {
+    remainder += divisor;
+    --quotient;
+  }
+}
+
+BigInteger BigInteger::ShiftLimbs(const BigInteger& value, size_t shift) {
+  BigInteger result = value;
+  if (!result.limbs_.Empty()) {
+    result.limbs_.Insert(0, shift, 0);
+  }
+  return result;
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1, Algorithm D. Requires divisor_size >= 2, a non-zero top divisor
+// limb and dividend_size >= divisor_size; writes dividend_size - divisor_size + 1 quotient limbs
+// and divisor_size remainder limbs.
+void BigInteger::KnuthDivide(const Limb* dividend, size_t dividend_size, const Limb* divisor, size_t divisor_size,
+                             Limb* quotient, Limb* remainder) {
+  // D1: shift both operands so that the top bit of the top divisor limb is set.
+  const int shift = __builtin_clzll(divisor[divisor_size - 1]);
+  auto shift_left = [shift](const Limb* limbs, size_t i) {
+    return shift == 0 ? limbs[i] : limbs[i] << shift | (i > 0 ? limbs[i - 1] >> (kLimbBits - shift) : 0);
+  };
+  std::vector<Limb> u(dividend_size + 1, 0);
+  std::vector<Limb> v(divisor_size, 0);
+  for (size_t i = 0; i < dividend_size; ++i) {
+    u[i] = shift_left(dividend, i);
+  }
+  u[dividend_size] = shift == 0 ? 0 : dividend[dividend_size - 1] >> (kLimbBits - shift);
+  for (size_t i = 0; i < divisor_size; ++i) {
+    v[i] = shift_left(divisor, i);
+  }
+
+  const Limb top = v[divisor_size - 1];
+  const Limb next = v[divisor_size - 2];
+
+  for (size_t j = dividend_size - divisor_size + 1; j-- > 0;) {
+    // D3: estimate the quotient limb from the top limbs; it is at most two too large.
+    UInt128 numerator = static_cast<UInt128>(u[j + divisor_size]) << kLimbBits | u[j + divisor_size - 1];
+    UInt128 estimate = numerator / top;
+    UInt128 rest = numerator % top;
+    while ((estimate >> kLimbBits) != 0 || estimate * next > (rest << kLimbBits | u[j + divisor_size - 2])) {
+      --estimate;
+      rest += top;
+      if ((rest >> kLimbBits) != 0) {
+        break;
+      }
+    }
+
+    // D4: multiply and subtract.
+    auto digit = static_cast<Limb>(estimate);
+    Limb borrow = 0;
+    Limb product_carry = 0;
+    for (size_t i = 0; i < divisor_size; ++i) {
+      UInt128 product = static_cast<UInt128>(digit) * v[i] + product_carry;
+      product_carry = static_cast<Limb>(product >> kLimbBits);
+      auto low = static_cast<Limb>(product);
+      Limb difference = u[i + j] - low;
+      Limb underflow = u[i + j] < low;
+      u[i + j] = difference - borrow;
+      borrow = underflow | (difference < borrow);
+    }
+    Limb difference = u[j + divisor_size] - product_carry;
+    Limb underflow = u[j + divisor_size] < product_carry;
+    u[j + divisor_size] = difference - borrow;
+    borrow = underflow | (difference < borrow);
+
+    // D6: the estimate was one too large, add the divisor back.
+    if (borrow) {
+      --digit;
+      Limb carry = 0;
+      for (size_t i = 0; i < divisor_size; ++i) {
+        UInt128 sum = static_cast<UInt128>(u[i + j]) + v[i] + carry;
+        u[i + j] = static_cast<Limb>(sum);
+        carry = static_cast<Limb>(sum >> kLimbBits);
+      }
+      u[j + divisor_size] += carry;
+    }
+
+    quotient[j] = digit;
+  }
+
+  // D8: unshift the remainder.
+  for (size_t i = 0; i < divisor_size; ++i) {
+    remainder[i] = shift == 0 ? u[i] : u[i] >> shift | u[i + 1] << (kLimbBits - shift);
+  }
+}
+
+BigInteger BigInteger::Pow(const BigInteger& base, uint64_t exponent) {
+  BigInteger result(1);
+  if (exponent == 0) {
+    return result;
+  }
+
+  result = base;
+  BigInteger scratch;
+  for (int bit = 62 - __builtin_clzll(exponent); bit >= 0; --bit) {
+    MultiplyHelper(result, result, scratch);
+    std::swap(result, scratch);
+    if ((exponent >> bit) & 1) {
+      MultiplyHelper(result, base, scratch);
+      std::swap(result, scratch);
+    }
+  }
+  return result;
+}
+
+BigInteger BigInteger::PowMod(const BigInteger& base, const BigInteger& exponent, const BigInteger& modulus) {
+  base.CheckDivision(modulus);
+  if (exponent.is_negative_) {
+    throw BigIntegerException("Negative exponent");
+  }
+
+  ModContext context(modulus);
+  BigInteger residue;
+  BigInteger one;
+  context.ToMontgomery(base, residue);
+  context.ToMontgomery(BigInteger(1), one);
+  auto multiply = [&context](const BigInteger& x, const BigInteger& y, BigInteger& out) {
+    context.MulMod(x, y, out);
+  };
+  BigInteger power = SlidingWindowPower(residue, one, exponent.limbs_.Data(), exponent.limbs_.Size(), multiply);
+  context.FromMontgomery(power, power);
+  return power;
+}
+
+BigInteger BigInteger::Factorial(uint64_t n) {
+  if (n < 2) {
+    return BigInteger(1);
+  }
+  if (kBigIntegerChecked && ExceedsDigits(LogRangeLowerBound(1, n), max_digit_count_)) {
+    throw BigIntegerOverflow();
+  }
+
+  // Odd part of n! as OddPart((n / 2)!)^2 * OddSwing(n), unrolled from the bottom up; the power of
+  // two is n - popcount(n).
+  const std::vector<uint64_t> primes = PrimesUpTo(n);
+  std::vector<uint64_t> levels;
+  for (uint64_t m = n; m >= 3; m /= 2) {
+    levels.push_back(m);
+  }
+  BigInteger result(1);
+  std::vector<uint64_t> factors;
+  for (size_t i = levels.size(); i-- > 0;) {
+    OddSwingFactors(levels[i], primes, factors);
+    result = Square(result) * ProductTree(factors.data(), factors.size());
+  }
+  result.ShiftLeft(n - __builtin_popcountll(n));
+  if (kBigIntegerChecked && result.ExceedsDigitCount(max_digit_count_)) {
+    throw BigIntegerOverflow();
+  }
+  return result;
+}
+
+BigInteger BigInteger::Binomial(uint64_t n, uint64_t k) {
+  if (k > n) {
+    return BigInteger(0);
+  }
+  k = std::min(k, n - k);
+  if (k == 0) {
+    return BigInteger(1);
+  }
+  // C(n, k) >= (n / k)^k.
+  if (kBigIntegerChecked &&
+      ExceedsDigits(static_cast<double>(k) * std::log(static_cast<double>(n) / static_cast<double>(k)),
+                    max_digit_count_)) {
+    throw BigIntegerOverflow();
+  }
+
+  // Primes above k only divide the numerator (n - k, n], so each numerator term is stripped of the
+  // primes up to k, whose exponents come from Legendre's formula instead. Every factor is at most n.
+  const uint64_t first = n - k + 1;
+  std::vector<uint64_t> factors(k);
+  for (uint64_t i = 0; i < k; ++i) {
+    factors[i] = first + i;
+  }
+  std::vector<uint64_t> powers;
+  for (uint64_t p : PrimesUpTo(k)) {
+    for (uint64_t i = (p - first % p) % p; i < k; i += p) {
+      do {
+        factors[i] /= p;
+      } while (factors[i] % p == 0);
+    }
+    uint64_t power = 1;
+    for (uint64_t a = n / p, b = k / p, c = (n - k) / p; a != 0; a /= p, b /= p, c /= p) {
+      if (a - b - c != 0) {
+        power *= p;
+      }
+    }
+    if (power != 1) {
+      powers.push_back(power);
+    }
+  }
+  factors.erase(std::remove(factors.begin(), factors.end(), uint64_t{1}), factors.end());
+  factors.insert(factors.end(), powers.begin(), powers.end());
+  return ProductTree(factors.data(), factors.size());
+}
+
+BigInteger BigInteger::ProductRange(uint64_t lo, uint64_t hi) {
+  if (hi < lo) {
+    return BigInteger(1);
+  }
+  if (lo == 0) {
+    return BigInteger(0);
+  }
+  if (kBigIntegerChecked && ExceedsDigits(LogRangeLowerBound(lo, hi), max_digit_count_)) {
+    throw BigIntegerOverflow();
+  }
+  return RangeProductTree(lo, hi);
+}
+
+BigInteger BigInteger::ProductTree(const uint64_t* factors, size_t count) {
+  if (count <= kProductTreeLeaf) {
+    BigInteger product(1);
+    for (size_t i = 0; i < count; ++i) {
+      product.MultiplyByNative(factors[i]);
+    }
+    return product;
+  }
+  const size_t half = count / 2;
+  return ProductTree(factors, half) * ProductTree(factors + half, count - half);
+}
+
+BigInteger BigInteger::RangeProductTree(uint64_t lo, uint64_t hi) {
+  if (hi - lo < kProductTreeLeaf) {
+    BigInteger product(1);
+    for (uint64_t factor = lo;; ++factor) {
+      product.MultiplyByNative(factor);
+      if (factor == hi) {
+        return product;
+      }
+    }
+  }
+  const uint64_t middle = lo + (hi - lo) / 2;
+  return RangeProductTree(lo, middle) * RangeProductTree(middle + 1, hi);
+}
+
+BigInteger BigInteger::Sqrt(const BigInteger& value) {
+  return Root(value, 2);
+}
+
+std::pair<BigInteger, BigInteger> BigInteger::SqrtRem(const BigInteger& value) {
+  BigInteger root = Sqrt(value);
+  BigInteger remainder = value - MultiplyParts(root, root);
+  return {std::move(root), std::move(remainder)};
+}
+
+BigInteger BigInteger::Root(const BigInteger& value, uint64_t k) {
+  if (k == 0) {
+    throw BigIntegerException("Zero root");
+  }
+  if (value.is_negative_ && k % 2 == 0) {
+    throw BigIntegerException("Root of a negative value");
+  }
+  if (k == 1 || !value) {
+    return value;
+  }
+  BigInteger root = NewtonRoot(value.Absolute(), k);
+  root.is_negative_ = value.is_negative_;
+  return root;
+}
+
+bool BigInteger::IsPerfectSquare(const BigInteger& value) {
+  if (!value) {
+    return true;
+  }
+  if (value.is_negative_ || !IsSquareResidue(value.limbs_[0] % 256, 0)) {
+    return false;
+  }
+  const uint64_t residue = Residue48(value.limbs_.Data(), value.limbs_.Size());
+  for (size_t i = 1; i < std::size(kSquareFilterModuli); ++i) {
+    if (!IsSquareResidue(residue % kSquareFilterModuli[i], i)) {
+      return false;
+    }
+  }
+  return !SqrtRem(value).second;
+}
+
+// floor(value^(1/k)) for value > 0 and k >= 2. The root of the value without its low k * h bits,
+// shifted back by h bits and rounded up, overestimates the result with about half of its bits
+// correct; a Newton step x -> ((k - 1) * x + value / x^(k - 1)) / k doubles that and never drops
+// below the root, so the steps stop as soon as x^k <= value.
+BigInteger BigInteger::NewtonRoot(const BigInteger& value, uint64_t k) {
+  const size_t bits = value.BitLength();
+  if (bits <= k) {
+    return BigInteger(1);
+  }
+  const size_t root_bits = (bits - 1) / k + 1;
+
+  BigInteger x;
+  if (root_bits <= 32) {
+    // log2 of the leading 64 bits is exact to far below one unit of the root.
+    size_t shift = bits > 64 ? bits - 64 : 0;
+    double log2 = std::log2(static_cast<double>(TopBits(value, shift))) + static_cast<double>(shift);
+    x = BigInteger(static_cast<int64_t>(std::exp2(log2 / static_cast<double>(k)) * (1 + 1e-9)) + 1);
+  } else {
+    const size_t half = root_bits / 2;
+    BigInteger top = value;
+    top.ShiftRight(k * half);
+    x = NewtonRoot(top, k);
+    x.AddNative(1, false);
+    x.ShiftLeft(half);
+  }
+
+  auto power = [](const BigInteger& base, uint64_t exponent) {
+    BigInteger result = base;
+    for (int bit = 62 - __builtin_clzll(exponent); bit >= 0; --bit) {
+      result = MultiplyParts(result, result);
+      if ((exponent >> bit) & 1) {
+        result = MultiplyParts(result, base);
+      }
+    }
+    return result;
+  };
+  BigInteger quotient;
+  BigInteger remainder;
+  while (true) {
+    BigInteger divisor = power(x, k - 1);
+    if (MultiplyParts(divisor, x) <= value) {
+      return x;
+    }
+    DivideHelper(value, divisor, quotient, remainder);
+    x.MultiplyByNative(k - 1);
+    x += quotient;
+    x.DivideByNative(k);
+  }
+}
+
+BigInteger BigInteger::Gcd(const BigInteger& a, const BigInteger& b) {
+  return GcdHelper(a, b, nullptr);
+}
+
+BigInteger BigInteger::Lcm(const BigInteger& a, const BigInteger& b) {
+  if (!a || !b) {
+    return BigInteger();
+  }
+  BigInteger quotient;
+  BigInteger remainder;
+  DivideHelper(a, Gcd(a, b), quotient, remainder);
+  BigInteger result;
+  MultiplyHelper(quotient, b, result);
+  result.is_negative_ = false;
+  return result;
+}
+
+BigInteger BigInteger::ExtendedGcd(const BigInteger& a, const BigInteger& b, BigInteger& x, BigInteger& y) {
+  BigInteger u;
+  BigInteger gcd = GcdHelper(a, b, &u);
+
+  // |a| * u + |b| * v = gcd, and v follows from an exact division.
+  BigInteger v;
+  if (b) {
+    BigInteger remainder;
+    DivideHelper(gcd - MultiplyParts(a.Absolute(), u), b.Absolute(), v, remainder);
+  }
+  u.is_negative_ = u && (u.is_negative_ != a.is_negative_);
+  v.is_negative_ = v && (v.is_negative_ != b.is_negative_);
+  x = std::move(u);
+  y = std::move(v);
+  return gcd;
+}
+
+BigInteger BigInteger::ModInverse(const BigInteger& a, const BigInteger& modulus) {
+  a.CheckDivision(modulus);
+  BigInteger x;
+  BigInteger y;
+  if (ExtendedGcd(a, modulus, x, y) != 1) {
+    throw BigIntegerException("Value is not invertible");
+  }
+
+  BigInteger divisor = modulus.Absolute();
+  BigInteger quotient;
+  BigInteger result;
+  DivideHelper(x, divisor, quotient, result);
+  if (result.is_negative_) {
+    result += divisor;
+  }
+  return result;
+}
+
+// The values before a run of Euclid steps are (m00 * a + m01 * b, m10 * a + m11 * b) in terms of the
+// values (a, b) after it. The entries are non-negative and the determinant is -1 exactly when negative
+// is set.
+struct BigInteger::GcdMatrix {
+  BigInteger m00 = 1;
+  BigInteger m01;
+  BigInteger m10;
+  BigInteger m11 = 1;
+  bool negative = false;
+
+  bool IsIdentity() const {
+    return !m01 && !m10;
+  }
+
+  // Appends the steps of other.
+  void Multiply(const GcdMatrix& other) {
+    BigInteger n00 = MultiplyParts(m00, other.m00) + MultiplyParts(m01, other.m10);
+    BigInteger n01 = MultiplyParts(m00, other.m01) + MultiplyParts(m01, other.m11);
+    BigInteger n10 = MultiplyParts(m10, other.m00) + MultiplyParts(m11, other.m10);
+    m11 = MultiplyParts(m10, other.m01) + MultiplyParts(m11, other.m11);
+    m00 = std::move(n00);
+    m01 = std::move(n01);
+    m10 = std::move(n10);
+    negative = negative != other.negative;
+  }
+
+  // Appends the steps simulated by LeadingEuclid; their matrix is the inverse of c.
+  void Append(const Cofactors& c) {
+    int64_t sign = c.m11 < 0 ? -1 : 1;
+    ApplyCofactors(m00, m01, sign * c.m11, -sign * c.m10, -sign * c.m01, sign * c.m00);
+    ApplyCofactors(m10, m11, sign * c.m11, -sign * c.m10, -sign * c.m01, sign * c.m00);
+    negative = negative != (sign < 0);
+  }
+
+  // Appends the step (a, b) -> (b, a - quotient * b).
+  void AppendQuotient(const BigInteger& quotient) {
+    BigInteger n00 = MultiplyParts(m00, quotient) + m01;
+    BigInteger n10 = MultiplyParts(m10, quotient) + m11;
+    m01 = std::move(m00);
+    m11 = std::move(m10);
+    m00 = std::move(n00);
+    m10 = std::move(n10);
+    negative = !negative;
+  }
+
+  // Appends the step (a, b) -> (a - quotient * b, b).
+  void AppendPartial(const BigInteger& quotient) {
+    m01 += MultiplyParts(m00, quotient);
+    m11 += MultiplyParts(m10, quotient);
+  }
+
+  // Appends (a, b) -> (b, a).
+  void SwapColumns() {
+    std::swap(m00, m01);
+    std::swap(m10, m11);
+    negative = !negative;
+  }
+
+  // (a, b) -> the inverse matrix times (a, b): the values after the steps from the values before them,
+  // or the same for any pair of cofactors of the values before them.
+  void ApplyInverse(BigInteger& a, BigInteger& b) const {
+    BigInteger x = MultiplyParts(m11, a) - MultiplyParts(m01, b);
+    BigInteger y = MultiplyParts(m00, b) - MultiplyParts(m10, a);
+    x.is_negative_ = x && (x.is_negative_ != negative);
+    y.is_negative_ = y && (y.is_negative_ != negative);
+    a = std::move(x);
+    b = std::move(y);
+  }
+};
+
+// Euclid's algorithm on |a| and |b|. While the smaller value has at least gcd_threshold_ limbs, each
+// round hands the leading two thirds of the limbs to HalfGcd, which takes about a third of the bits
+// off both values at once. Below that, Lehmer's algorithm ("Euclid's Algorithm for Large Numbers",
+// 1938) simulates runs of steps on the leading 62 bits with single-precision cofactors and applies them
+// to the full values at once; a multi-precision division is only needed when the leading bits cannot
+// determine the next quotient. When cofactor is not null it receives u with |a| * u = gcd (mod |b|).
+BigInteger BigInteger::GcdHelper(BigInteger a, BigInteger b, BigInteger* cofactor) {
+  a.is_negative_ = false;
+  b.is_negative_ = false;
+  BigInteger u(1);
+  BigInteger u_next;
+  if (a < b) {
+    std::swap(a, b);
+    std::swap(u, u_next);
+  }
+
+  BigInteger quotient;
+  BigInteger remainder;
+  auto divide_step = [&]() {
+    DivideHelper(a, b, quotient, remainder);
+    a = std::move(b);
+    b = std::move(remainder);
+    if (cofactor != nullptr) {
+      u -= MultiplyParts(quotient, u_next);
+      std::swap(u, u_next);
+    }
+  };
+
+  while (b.limbs_.Size() >= gcd_threshold_) {
+    GcdMatrix matrix;
+    if (!ReduceByLeadingLimbs(a, b, a.limbs_.Size() / 3, matrix)) {
+      divide_step();
+    } else if (cofactor != nullptr) {
+      matrix.ApplyInverse(u, u_next);
+    }
+  }
+
+  while (b.limbs_.Size() > 1) {
+    size_t shift = a.BitLength() - kLeadingGcdBits;
+    Cofactors m = LeadingEuclid(static_cast<int64_t>(TopBits(a, shift)), static_cast<int64_t>(TopBits(b, shift)), 1);
+    if (m.m01 == 0) {
+      divide_step();
+    } else {
+      ApplyCofactors(a, b, m.m00, m.m01, m.m10, m.m11);
+      if (cofactor != nullptr) {
+        BigInteger u_combined = u * m.m00 + u_next * m.m01;
+        u_next = u * m.m10 + u_next * m.m11;
+        u = std::move(u_combined);
+      }
+    }
+  }
+
+  if (cofactor != nullptr) {
+    while (b) {
+      divide_step();
+    }
+    *cofactor = std::move(u);
+    return a;
+  }
+
+  // Both values fit in a limb once the remainder does.
+  if (b) {
+    Limb y = b.limbs_[0];
+    Limb x = a.DivideByNative(y);
+    while (x != 0) {
+      y %= x;
+      std::swap(x, y);
+    }
+    a.limbs_.Clear();
+    a.AddLimb(y);
+  }
+  return a;
+}
+
+// Schönhage's half-gcd in the formulation of Möller, "On Schönhage's algorithm and subquadratic integer
+// gcd computation" (2008). For a >= b and s = a.BitLength() / 2 + 1, takes Euclid steps that keep both
+// values at least 2^s until none is left (then a - b < 2^s) and sets matrix to their product; its
+// entries stay below 2^(a.BitLength() - s). Above the threshold two recursive calls on the leading
+// halves do most of the work. Returns false when no step was possible.
+bool BigInteger::HalfGcd(BigInteger& a, BigInteger& b, GcdMatrix& matrix) {
+  matrix = GcdMatrix();
+  const size_t bits = a.BitLength();
+  const size_t floor_bits = bits / 2 + 1;
+  if (b.BitLength() <= floor_bits) {
+    return false;
+  }
+
+  if (a.limbs_.Size() >= gcd_threshold_) {
+    ReduceByLeadingLimbs(a, b, (floor_bits + kLimbBits - 1) / kLimbBits, matrix);
+    LehmerReduce(a, b, floor_bits, bits * 3 / 4, matrix);
+    // a is down to about 3/4 of the bits; the second call works on the leading 2 * (a.BitLength() - s).
+    GcdMatrix next;
+    if (ReduceByLeadingLimbs(a, b, (2 * floor_bits + kLimbBits - a.BitLength()) / kLimbBits, next)) {
+      matrix.Multiply(next);
+    }
+  }
+  LehmerReduce(a, b, floor_bits, floor_bits, matrix);
+  return !matrix.IsIdentity();
+}
+
+// Runs HalfGcd on the values without their low shift limbs and applies the resulting steps to the full
+// a >= b. If a has n bits and shift * kLimbBits + (n - shift * kLimbBits) / 2 >= s, the steps keep both
+// values at least 2^s: the low limbs change them by less than 2^(64 * shift) times the largest matrix
+// entry, which stays well below what HalfGcd leaves of the leading part.
+bool BigInteger::ReduceByLeadingLimbs(BigInteger& a, BigInteger& b, size_t shift, GcdMatrix& matrix) {
+  BigInteger a_top = SliceLimbs(a.limbs_.Data(), a.limbs_.Size(), shift, a.limbs_.Size());
+  BigInteger b_top = SliceLimbs(b.limbs_.Data(), b.limbs_.Size(), shift, b.limbs_.Size());
+  if (!HalfGcd(a_top, b_top, matrix)) {
+    return false;
+  }
+  matrix.ApplyInverse(a, b);
+  if (a < b) {
+    std::swap(a, b);
+    matrix.SwapColumns();
+  }
+  return true;
+}
+
+// Euclid steps on a >= b that keep both values at least 2^floor_bits, while a has more than stop_bits
+// bits; runs of them are simulated on the leading bits where possible. When the next full step would
+// leave less, a takes the partial step (a, b) -> (a - q * b, b) with the largest such q instead and the
+// reduction ends. The steps are appended to matrix.
+void BigInteger::LehmerReduce(BigInteger& a, BigInteger& b, size_t floor_bits, size_t stop_bits,
+                              GcdMatrix& matrix) {
+  BigInteger quotient;
+  BigInteger remainder;
+  while (a.BitLength() > stop_bits && b.BitLength() > floor_bits) {
+    size_t bits = a.BitLength();
+    if (bits >= kLeadingGcdBits && floor_bits < bits) {
+      size_t shift = bits - kLeadingGcdBits;
+      int64_t floor = floor_bits > shift ? int64_t{1} << (floor_bits - shift) : 1;
+      Cofactors m =
+          LeadingEuclid(static_cast<int64_t>(TopBits(a, shift)), static_cast<int64_t>(TopBits(b, shift)), floor);
+      if (m.m01 != 0) {
+        ApplyCofactors(a, b, m.m00, m.m01, m.m10, m.m11);
+        matrix.Append(m);
+        continue;
+      }
+    }
+
+    DivideHelper(a, b, quotient, remainder);
+    if (remainder.BitLength() > floor_bits) {
+      a = std::move(b);
+      b = std::move(remainder);
+      matrix.AppendQuotient(quotient);
+      continue;
+    }
+
+    const BigInteger floor = BigInteger(1) << floor_bits;
+    BigInteger excess = a - floor;
+    if (excess >= b) {
+      DivideHelper(excess, b, quotient, remainder);
+      a = remainder + floor;
+      matrix.AppendPartial(quotient);
+    }
+    return;
+  }
+}
+
+// Bits [shift, shift + 64) of a non-negative value.
+BigInteger::Limb BigInteger::TopBits(const BigInteger& value, size_t shift) {
+  size_t index = shift / kLimbBits;
+  int offset = static_cast<int>(shift % kLimbBits);
+  Limb low = index < value.limbs_.Size() ? value.limbs_[index] : 0;
+  Limb high = index + 1 < value.limbs_.Size() ? value.limbs_[index + 1] : 0;
+  return offset == 0 ? low : low >> offset | high << (kLimbBits - offset);
+}
+
+// (a, b) = (m00 * a + m01 * b, m10 * a + m11 * b) for a cofactor matrix that keeps both non-negative.
+void BigInteger::ApplyCofactors(BigInteger& a, BigInteger& b, int64_t m00, int64_t m01, int64_t m10, int64_t m11) {
+  size_t size = std::max(a.limbs_.Size(), b.limbs_.Size());
+  a.limbs_.Resize(size, 0);
+  b.limbs_.Resize(size, 0);
+  Int128 a_carry = 0;
+  Int128 b_carry = 0;
+  for (size_t i = 0; i < size; ++i) {
+    Limb a_limb = a.limbs_[i];
+    Limb b_limb = b.limbs_[i];
+    a_carry += static_cast<Int128>(a_limb) * m00 + static_cast<Int128>(b_limb) * m01;
+    b_carry += static_cast<Int128>(a_limb) * m10 + static_cast<Int128>(b_limb) * m11;
+    a.limbs_[i] = static_cast<Limb>(a_carry);
+    b.limbs_[i] = static_cast<Limb>(b_carry);
+    a_carry >>= kLimbBits;
+    b_carry >>= kLimbBits;
+  }
+  a.limbs_.PushBack(static_cast<Limb>(a_carry));
+  b.limbs_.PushBack(static_cast<Limb>(b_carry));
+  a.Normalize();
+  b.Normalize();
+}
+
+BigInteger& BigInteger::operator<<=(size_t shift) {
+  ShiftLeft(shift);
+  return *this;
+}
+
+// Rounds toward minus infinity, like the arithmetic shift of the two's complement form.
+BigInteger& BigInteger::operator>>=(size_t shift) {
+  const bool round_down = is_negative_ && CountTrailingZeros() < shift;
+  ShiftRight(shift);
+  if (round_down) {
+    *this -= 1;
+  }
+  return *this;
+}
+
+BigInteger& BigInteger::operator&=(const BigInteger& other) {
+  const size_t size = limbs_.Size();
+  const size_t other_size = other.limbs_.Size();
+  limbs_.Resize(std::max(size, other_size) + 1, 0);
+  is_negative_ = CombineBits(limbs_.Data(), size, is_negative_, other.limbs_.Data(), other_size, other.is_negative_,
+                             limbs_.Data(),
+                             [](uint64_t x, uint64_t y) { return x & y; });
+  Normalize();
+  return *this;
+}
+
+BigInteger& BigInteger::operator|=(const BigInteger& other) {
+  const size_t size = limbs_.Size();
+  const size_t other_size = other.limbs_.Size();
+  limbs_.Resize(std::max(size, other_size) + 1, 0);
+  is_negative_ = CombineBits(limbs_.Data(), size, is_negative_, other.limbs_.Data(), other_size, other.is_negative_,
+                             limbs_.Data(),
+                             [](uint64_t x, uint64_t y) { return x | y; });
+  Normalize();
+  return *this;
+}
+
+BigInteger& BigInteger::operator^=(const BigInteger& other) {
+  const size_t size = limbs_.Size();
+  const size_t other_size = other.limbs_.Size();
+  limbs_.Resize(std::max(size, other_size) + 1, 0);
+  is_negative_ = CombineBits(limbs_.Data(), size, is_negative_, other.limbs_.Data(), other_size, other.is_negative_,
+                             limbs_.Data(),
+                             [](uint64_t x, uint64_t y) { return x ^ y; });
+  Normalize();
+  return *this;
+}
+
+// ~x = -x - 1.
+BigInteger BigInteger::operator~() const {
+  BigInteger result = -*this;
+  result -= 1;
+  return result;
+}
+
+size_t BigInteger::PopCount() const {
+  size_t count = 0;
+  for (Limb limb : limbs_) {
+    count += __builtin_popcountll(limb);
+  }
+  return count;
+}
+
+// Bit index of the two's complement form: below the lowest set bit of the magnitude, -x has the same
+// bits as x, and above it the complemented ones.
+bool BigInteger::TestBit(size_t index) const {
+  const size_t limb = index / kLimbBits;
+  const bool bit = limb < limbs_.Size() && (limbs_[limb] >> (index % kLimbBits) & 1) != 0;
+  if (!is_negative_) {
+    return bit;
+  }
+  const size_t lowest = CountTrailingZeros();
+  return index <= lowest ? bit : !bit;
+}
+
+size_t BigInteger::CountTrailingZeros() const {
+  for (size_t i = 0; i < limbs_.Size(); ++i) {
+    if (limbs_[i] != 0) {
+      return i * kLimbBits + __builtin_ctzll(limbs_[i]);
+    }
+  }
+  return 0;
+}
+
+BigInteger::operator bool() const {
+  return !limbs_.Empty();
+}
+
+BigInteger& BigInteger::operator++() {
+  OperationScope scope(Operation::kIncrement, limbs_.Size());
+  AddNative(1, false);
+  return *this;
+}
+
+BigInteger BigInteger::operator++(int) {
+  BigInteger temp = *this;
+  ++*this;
+  return temp;
+}
+
+BigInteger& BigInteger::operator--() {
+  OperationScope scope(Operation::kIncrement, limbs_.Size());
+  AddNative(1, true);
+  return *this;
+}
+
+BigInteger BigInteger::operator--(int) {
+  BigInteger temp = *this;
+  --*this;
+  return temp;
+}
+
+BigInteger& BigInteger::operator+=(int64_t other) {
+  return AddOperand(MagnitudeOf(other), other < 0, Operation::kAdd);
+}
+
+BigInteger& BigInteger::operator-=(int64_t other) {
+  return AddOperand(MagnitudeOf(other), other > 0, Operation::kSubtract);
+}
+
+BigInteger& BigInteger::operator*=(int64_t other) {
+  return MultiplyOperand(MagnitudeOf(other), other < 0);
+}
+
+BigInteger& BigInteger::operator/=(int64_t other) {
+  DivideWithRemainder(other);
+  return *this;
+}
+
+BigInteger& BigInteger::operator%=(int64_t other) {
+  return ModuloOperand(MagnitudeOf(other));
+}
+
+BigInteger& BigInteger::AddOperand(uint64_t magnitude, bool negative, Operation operation) {
+  OperationScope scope(operation, limbs_.Size());
+  AddNative(magnitude, negative);
+  return *this;
+}
+
+BigInteger& BigInteger::MultiplyOperand(uint64_t magnitude, bool negative) {
+  OperationScope scope(Operation::kMultiply, limbs_.Size());
+  MultiplyByNative(magnitude);
+  is_negative_ = is_negative_ != negative;
+  Normalize();
+  return *this;
+}
+
+BigInteger& BigInteger::DivideOperand(uint64_t magnitude, bool negative) {
+  OperationScope scope(Operation::kDivide, limbs_.Size());
+  if (magnitude == 0) {
+    throw BigIntegerDivisionByZero();
+  }
+  DivideByNative(magnitude);
+  is_negative_ = is_negative_ != negative;
+  Normalize();
+  return *this;
+}
+
+// The remainder takes the sign of the dividend, so only the magnitude of the divisor matters.
+BigInteger& BigInteger::ModuloOperand(uint64_t magnitude) {
+  OperationScope scope(Operation::kDivide, limbs_.Size());
+  if (magnitude == 0) {
+    throw BigIntegerDivisionByZero();
+  }
+  uint64_t remainder = DivideByNative(magnitude);
+  limbs_.Clear();
+  AddLimb(remainder);
+  Normalize();
+  return *this;
+}
+
+int64_t BigInteger::DivideWithRemainder(int64_t divisor) {
+  OperationScope scope(Operation::kDivide, limbs_.Size());
+  if (divisor == 0) {
+    throw BigIntegerDivisionByZero();
+  }
+  bool negative = is_negative_;
+  auto remainder = static_cast<int64_t>(DivideByNative(MagnitudeOf(divisor)));
+  is_negative_ = negative != (divisor < 0);
+  Normalize();
+  return negative ? -remainder : remainder;
+}
+
+// Adds (-1)^negative * magnitude in place.
+void BigInteger::AddNative(uint64_t magnitude, bool negative) {
+  if (magnitude == 0) {
+    return;
+  }
+
+  Limb limb = magnitude;
+  if (limbs_.Empty() || is_negative_ == negative) {
+    is_negative_ = negative;
+    limbs_.Resize(std::max<size_t>(limbs_.Size(), 1), 0);
+    AddLimb(AddLimbs(limbs_.Data(), limbs_.Size(), &limb, 1));
+  } else if (CompareLimbs(limbs_.Data(), limbs_.Size(), &limb, 1) >= 0) {
+    SubtractLimbs(limbs_.Data(), limbs_.Size(), &limb, 1);
+  } else {
+    limbs_[0] = limb - limbs_[0];
+    is_negative_ = negative;
+  }
+
+  Normalize();
+}
+
+// Multiplies the magnitude in place; the caller fixes the sign.
+void BigInteger::MultiplyByNative(uint64_t magnitude) {
+  AddLimb(MultiplyAddLimbs(limbs_.Data(), limbs_.Size(), magnitude, 0));
+}
+
+// Shift the magnitude in place by whole bits; the caller fixes the sign.
+void BigInteger::ShiftLeft(size_t bits) {
+  if (limbs_.Empty()) {
+    return;
+  }
+  const int offset = static_cast<int>(bits % kLimbBits);
+  if (offset != 0) {
+    Limb carry = 0;
+    for (Limb& limb : limbs_) {
+      Limb next = limb >> (kLimbBits - offset);
+      limb = limb << offset | carry;
+      carry = next;
+    }
+    if (carry != 0) {
+      limbs_.PushBack(carry);
+    }
+  }
+  limbs_.Insert(0, bits / kLimbBits, 0);
+}
+
+void BigInteger::ShiftRight(size_t bits) {
+  const size_t skip = bits / kLimbBits;
+  if (skip >= limbs_.Size()) {
+    limbs_.Clear();
+    Normalize();
+    return;
+  }
+  limbs_.Assign(limbs_.begin() + skip, limbs_.end());
+  const int offset = static_cast<int>(bits % kLimbBits);
+  if (offset != 0) {
+    const size_t size = limbs_.Size();
+    for (size_t i = 0; i < size; ++i) {
+      Limb high = i + 1 < size ? limbs_[i + 1] << (kLimbBits - offset) : 0;
+      limbs_[i] = limbs_[i] >> offset | high;
+    }
+  }
+  Normalize();
+}
+
+// Divides the magnitude in place and returns the magnitude of the remainder; the caller fixes the sign.
+uint64_t BigInteger::DivideByNative(uint64_t magnitude) {
+  uint64_t remainder = DivideLimbsByNative(limbs_.Data(), limbs_.Size(), magnitude);
+  RemoveLeadingZeros();
+  return remainder;
+}
+
+size_t BigInteger::BitLength() const {
+  if (limbs_.Empty()) {
+    return 0;
+  }
+  return limbs_.Size() * kLimbBits - __builtin_clzll(limbs_.Back());
+}
+
+size_t BigInteger::DigitCount() const {
+  if (limbs_.Size() <= 1) {
+    Limb value = limbs_.Empty() ? 0 : limbs_[0];
+    size_t count = 1;
+    for (; value >= 10; value /= 10) {
+      ++count;
+    }
+    return count;
+  }
+
+  // The bit length pins the answer down to one of two candidates; compare against 10^count.
+  size_t count = MinDecimalDigits(BitLength());
+  BigInteger power = PowerOfTen(count);
+  while (CompareLimbs(limbs_.Data(), limbs_.Size(), power.limbs_.Data(), power.limbs_.Size()) >= 0) {
+    power.MultiplyByNative(10);
+    ++count;
+  }
+  return count;
+}
+
+// Equivalent to DigitCount() > limit, but only converts when the bit length is inconclusive.
+bool BigInteger::ExceedsDigitCount(size_t limit) const {
+  if (limbs_.Empty()) {
+    return limit < 1;
+  }
+  size_t bits = BitLength();
+  if (MinDecimalDigits(bits) > limit) {
+    return true;
+  }
+  if (MaxDecimalDigits(bits) <= limit) {
+    return false;
+  }
+  return DigitCount() > limit;
+}
+
+BigInteger BigInteger::PowerOfTen(size_t exponent) {
+  BigInteger result(1);
+  BigInteger base(10);
+  for (; exponent > 0; exponent >>= 1) {
+    if (exponent & 1) {
+      result = MultiplyParts(result, base);
+    }
+    if (exponent > 1) {
+      base = MultiplyParts(base, base);
+    }
+  }
+  return result;
+}
+
+void BigInteger::CompareDigits(const BigInteger& a, const BigInteger& b, int& result) {
+  result = CompareLimbs(a.limbs_.Data(), a.limbs_.Size(), b.limbs_.Data(), b.limbs_.Size());
+}
+
+int BigInteger::CompareLimbs(const Limb* a, size_t a_size, const Limb* b, size_t b_size) {
+  if (a_size != b_size) {
+    return (a_size < b_size) ? -1 : 1;
+  }
+
+  size_t i = a_size;
+  const auto trim_equal = a_size >= kVectorLimbs ? ActiveKernels().trim_equal : nullptr;
+  if (trim_equal != nullptr) {
+    i = trim_equal(a, b, a_size);
+  }
+  for (; i-- > 0;) {
+    if (a[i] != b[i]) {
+      return (a[i] < b[i]) ? -1 : 1;
+    }
+  }
+
+  return 0;
+}
+
+// Compares with (-1)^negative * magnitude.
+int BigInteger::CompareWith(uint64_t magnitude, bool negative) const {
+  if (is_negative_ != negative) {
+    return is_negative_ ? -1 : 1;
+  }
+
+  OperationScope scope(Operation::kCompare, limbs_.Size());
+  Limb limb = magnitude;
+  int order = CompareLimbs(limbs_.Data(), limbs_.Size(), &limb, limb != 0);
+  return negative ? -order : order;
+}
+
+bool operator==(const BigInteger& a, const BigInteger& b) {
+  OperationScope scope(BigInteger::Operation::kCompare, std::max(a.limbs_.Size(), b.limbs_.Size()));
+  return !(a < b) && !(b < a);
+}
+
+bool operator!=(const BigInteger& a, const BigInteger& b) {
+  return !(a == b);
+}
+
+bool operator<(const BigInteger& a, const BigInteger& b) {
+  OperationScope scope(BigInteger::Operation::kCompare, std::max(a.limbs_.Size(), b.limbs_.Size()));
+  if (a.is_negative_ != b.is_negative_) {
+    return a.is_negative_;
+  }
+  if (a.limbs_.Size() != b.limbs_.Size()) {
+    return (a.limbs_.Size() < b.limbs_.Size()) != a.is_negative_;
+  }
+  for (int i = static_cast<int>(a.limbs_.Size()) - 1; i >= 0; --i) {
+    if (a.limbs_[i] != b.limbs_[i]) {
+      return (a.limbs_[i] < b.limbs_[i]) != a.is_negative_;
+    }
+  }
+  return false;
+}
+
+bool operator==(const BigInteger& a, int64_t b) {
+  return a.CompareWith(MagnitudeOf(b), b < 0) == 0;
+}
+
+bool operator!=(const BigInteger& a, int64_t b) {
+  return a.CompareWith(MagnitudeOf(b), b < 0) != 0;
+}
+
+bool operator<(const BigInteger& a, int64_t b) {
+  return a.CompareWith(MagnitudeOf(b), b < 0) < 0;
+}
+
+bool operator<=(const BigInteger& a, int64_t b) {
+  return a.CompareWith(MagnitudeOf(b), b < 0) <= 0;
+}
+
+bool operator>(const BigInteger& a, int64_t b) {
+  return a.CompareWith(MagnitudeOf(b), b < 0) > 0;
+}
+
+bool operator>=(const BigInteger& a, int64_t b) {
+  return a.CompareWith(MagnitudeOf(b), b < 0) >= 0;
+}
+
+bool operator==(int64_t a, const BigInteger& b) {
+  return b.CompareWith(MagnitudeOf(a), a < 0) == 0;
+}
+
+bool operator!=(int64_t a, const BigInteger& b) {
+  return b.CompareWith(MagnitudeOf(a), a < 0) != 0;
+}
+
+bool operator<(int64_t a, const BigInteger& b) {
+  return b.CompareWith(MagnitudeOf(a), a < 0) > 0;
+}
+
+bool operator<=(int64_t a, const BigInteger& b) {
+  return b.CompareWith(MagnitudeOf(a), a < 0) >= 0;
+}
+
+bool operator>(int64_t a, const BigInteger& b) {
+  return b.CompareWith(MagnitudeOf(a), a < 0) < 0;
+}
+
+bool operator>=(int64_t a, const BigInteger& b) {
+  return b.CompareWith(MagnitudeOf(a), a < 0) <= 0;
+}
+
+bool operator<=(const BigInteger& a, const BigInteger& b) {
+  return !(b < a);
+}
+
+bool operator>(const BigInteger& a, const BigInteger& b) {
+  return b < a;
+}
+
+bool operator>=(const BigInteger& a, const BigInteger& b) {
+  return !(a < b);
+}
+
+std::ostream& operator<<(std::ostream& os, const BigInteger& value) {
+  if (value.is_negative_) {
+    os << '-';
+  }
+  if (value.limbs_.Empty()) {
+    return os << '0';
+  }
+
+  // powers[k] = kDecimalBase^(2^k), up to about a quarter of the value's size.
+  std::vector<BigInteger> powers;
+  size_t size = value.limbs_.Size();
+  OperationScope scope(BigInteger::Operation::kPrint, size);
+  if (size > BigInteger::kDecimalThreshold) {
+    scope.SetTier(BigInteger::Tier::kSubquadratic);
+    powers.resize(1);
+    powers[0].limbs_.PushBack(BigInteger::kDecimalBase);
+    while (4 * powers.back().limbs_.Size() <= size + 1) {
+      powers.push_back(BigInteger::MultiplyParts(powers.back(), powers.back()));
+    }
+  }
+
+  std::string digits;
+  BigInteger::AppendDecimal(value.Absolute(), 0, powers, digits);
+  return os << digits;
+}
+
+// Appends the decimal digits of a non-negative value, left-padded with zeros to width digits.
+// Large values are split by the power of kDecimalBase closest to their square root.
+void BigInteger::AppendDecimal(const BigInteger& magnitude, size_t width, const std::vector<BigInteger>& powers,
+                               std::string& out) {
+  size_t size = magnitude.limbs_.Size();
+  if (size <= kDecimalThreshold) {
+    BigInteger rest = magnitude;
+    std::string reversed;
+    while (!rest.limbs_.Empty()) {
+      Limb chunk = rest.DivideByNative(kDecimalBase);
+      for (int i = 0; i < kDecimalBaseDigits; ++i, chunk /= 10) {
+        reversed.push_back(static_cast<char>('0' + chunk % 10));
+      }
+    }
+    while (!reversed.empty() && reversed.back() == '0') {
+      reversed.pop_back();
+    }
+    if (reversed.size() < width) {
+      reversed.resize(width, '0');
+    }
+    out.append(reversed.rbegin(), reversed.rend());
+    return;
+  }
+
+  size_t level = powers.size() - 1;
+  while (level > 0 && 2 * powers[level].limbs_.Size() > size + 1) {
+    --level;
+  }
+  BigInteger quotient;
+  BigInteger remainder;
+  DivideHelper(magnitude, powers[level], quotient, remainder);
+  size_t low_width = static_cast<size_t>(kDecimalBaseDigits) << level;
+  AppendDecimal(quotient, width > low_width ? width - low_width : 0, powers, out);
+  AppendDecimal(remainder, low_width, powers, out);
+}
+
+std::istream& operator>>(std::istream& is, BigInteger& value) {
+  std::string s;
+  is >> s;
+  value = BigInteger(s);
+  return is;
+}
+
+BigInteger operator+(BigInteger a, const BigInteger& b) {
+  return a += b;
+}
+
+BigInteger operator-(BigInteger a, const BigInteger& b) {
+  return a -= b;
+}
+
+BigInteger operator*(const BigInteger& a, const BigInteger& b) {
+  return BigInteger::Multiply(a, b);
+}
+
+BigInteger operator/(BigInteger a, const BigInteger& b) {
+  return a /= b;
+}
+
+BigInteger operator%(BigInteger a, const BigInteger& b) {
+  return a %= b;
+}
+
+BigInteger operator<<(BigInteger a, size_t shift) {
+  return a <<= shift;
+}
+
+BigInteger operator>>(BigInteger a, size_t shift) {
+  return a >>= shift;
+}
+
+BigInteger operator&(BigInteger a, const BigInteger& b) {
+  return a &= b;
+}
+
+BigInteger operator|(BigInteger a, const BigInteger& b) {
+  return a |= b;
+}
+
+BigInteger operator^(BigInteger a, const BigInteger& b) {
+  return a ^= b;
+}
+
+BigInteger operator+(BigInteger a, int64_t b) {
+  return a += b;
+}
+
+BigInteger operator+(int64_t a, BigInteger b) {
+  return b += a;
+}
+
+BigInteger operator-(BigInteger a, int64_t b) {
+  return a -= b;
+}
+
+BigInteger operator*(BigInteger a, int64_t b) {
+  return a *= b;
+}
+
+BigInteger operator*(int64_t a, BigInteger b) {
+  return b *= a;
+}
+
+BigInteger operator/(BigInteger a, int64_t b) {
+  return a /= b;
+}
+
+BigInteger operator%(BigInteger a, int64_t b) {
+  return a %= b;
+}
+
+ModContext::ModContext(const BigInteger& modulus)
+    : modulus_(modulus.Absolute()), size_(modulus.limbs_.Size()), montgomery_(false), inverse_(0), mask_bits_(0) {
+  modulus.CheckDivision(modulus);
+  const Limb* limbs = modulus_.limbs_.Data();
+  product_.resize(2 * size_ + 2);
+  scratch_.resize(4 * size_ + 3);
+
+  BigInteger quotient;
+  if (limbs[0] & 1) {
+    // Montgomery, "Modular Multiplication Without Trial Division" (1985).
+    // inverse_ = -m^-1 mod 2^64; each Newton step doubles the number of correct low bits.
+    montgomery_ = true;
+    inverse_ = limbs[0];
+    for (int i = 0; i < 5; ++i) {
+      inverse_ *= 2 - limbs[0] * inverse_;
+    }
+    inverse_ = 0 - inverse_;
+    BigInteger::DivideHelper(BigInteger::ShiftLimbs(BigInteger(1), 2 * size_), modulus_, quotient, r_squared_);
+  } else if (modulus_.PopCount() == 1) {
+    // floor(2^(128 * n) / m) would not fit in n + 1 limbs for m = 2^(64 * (n - 1)), and a mask is
+    // cheaper anyway.
+    mask_bits_ = modulus_.BitLength() - 1;
+  } else {
+    // Barrett, "Implementing the RSA Public Key Encryption Algorithm on a Standard Digital Signal
+    // Processor" (1986). reciprocal_ = floor(2^(128 * n) / m), zero-padded to n + 1 limbs.
+    BigInteger remainder;
+    BigInteger::DivideHelper(BigInteger::ShiftLimbs(BigInteger(1), 2 * size_), modulus_, quotient, remainder);
+    reciprocal_.assign(size_ + 1, 0);
+    std::copy(quotient.limbs_.begin(), quotient.limbs_.end(), reciprocal_.begin());
+  }
+}
+
+const BigInteger& ModContext::Modulus() const {
+  return modulus_;
+}
+
+bool ModContext::IsMontgomery() const {
+  return montgomery_;
+}
+
+void ModContext::ToMontgomery(const BigInteger& value, BigInteger& result) const {
+  BigInteger quotient;
+  BigInteger residue;
+  BigInteger::DivideHelper(value, modulus_, quotient, residue);
+  if (residue.is_negative_) {
+    residue += modulus_;
+  }
+  if (montgomery_) {
+    MulMod(residue, r_squared_, result);
+  } else {
+    result = std::move(residue);
+  }
+}
+
+void ModContext::FromMontgomery(const BigInteger& value, BigInteger& result) const {
+  CheckResidue(value);
+  if (!montgomery_) {
+    result = value;
+    return;
+  }
+  std::fill(product_.begin(), product_.end(), 0);
+  std::copy(value.limbs_.begin(), value.limbs_.end(), product_.begin());
+  Reduce(result);
+}
+
+void ModContext::AddMod(const BigInteger& a, const BigInteger& b, BigInteger& result) const {
+  CheckResidue(a);
+  CheckResidue(b);
+  Limb* sum = scratch_.data();
+  std::fill(sum, sum + size_ + 1, 0);
+  std::copy(a.limbs_.begin(), a.limbs_.end(), sum);
+  BigInteger::AddLimbs(sum, size_ + 1, b.limbs_.Data(), b.limbs_.Size());
+  const Limb* modulus = modulus_.limbs_.Data();
+  if (sum[size_] != 0 || BigInteger::CompareLimbs(sum, size_, modulus, size_) >= 0) {
+    BigInteger::SubtractLimbs(sum, size_ + 1, modulus, size_);
+  }
+  Store(sum, result);
+}
+
+void ModContext::SubMod(const BigInteger& a, const BigInteger& b, BigInteger& result) const {
+  CheckResidue(a);
+  CheckResidue(b);
+  Limb* difference = scratch_.data();
+  std::fill(difference, difference + size_ + 1, 0);
+  std::copy(a.limbs_.begin(), a.limbs_.end(), difference);
+  if (BigInteger::CompareLimbs(a.limbs_.Data(), a.limbs_.Size(), b.limbs_.Data(), b.limbs_.Size()) < 0) {
+    BigInteger::AddLimbs(difference, size_ + 1, modulus_.limbs_.Data(), size_);
+  }
+  BigInteger::SubtractLimbs(difference, size_ + 1, b.limbs_.Data(), b.limbs_.Size());
+  Store(difference, result);
+}
+
+void ModContext::MulMod(const BigInteger& a, const BigInteger& b, BigInteger& result) const {
+  CheckResidue(a);
+  CheckResidue(b);
+  if (a.limbs_.Empty() || b.limbs_.Empty()) {
+    result.limbs_.Clear();
+    result.is_negative_ = false;
+    return;
+  }
+
+  std::fill(product_.begin(), product_.end(), 0);
+  if (a.limbs_.Size() >= b.limbs_.Size()) {
+    BigInteger::MultiplyLimbs(a.limbs_.Data(), a.limbs_.Size(), b.limbs_.Data(), b.limbs_.Size(), product_.data());
+  } else {
+    BigInteger::MultiplyLimbs(b.limbs_.Data(), b.limbs_.Size(), a.limbs_.Data(), a.limbs_.Size(), product_.data());
+  }
+  Reduce(result);
+}
+
+void ModContext::SqrMod(const BigInteger& a, BigInteger& result) const {
+  MulMod(a, a, result);
+}
+
+// Operands beyond n limbs would overrun the context's buffers, so the checked build rejects anything
+// outside [0, m).
+void ModContext::CheckResidue(const BigInteger& value) const {
+  if constexpr (kBigIntegerChecked) {
+    if (value.is_negative_ || BigInteger::CompareLimbs(value.limbs_.Data(), value.limbs_.Size(),
+                                                       modulus_.limbs_.Data(), size_) >= 0) {
+      throw BigIntegerException("ModContext operand is not reduced");
+    }
+  }
+}
+
+// Reduces the value in product_ (below m^2, or below m * 2^(64 * n) in Montgomery mode) into result.
+void ModContext::Reduce(BigInteger& result) const {
+  const Limb* modulus = modulus_.limbs_.Data();
+  Limb* reduced = nullptr;
+
+  if (montgomery_) {
+    // Clear one low limb per step by adding a multiple of the modulus, then divide by 2^(64 * n).
+    for (size_t i = 0; i < size_; ++i) {
+      Limb carry = MultiplyAccumulateLimbs(product_.data() + i, modulus, size_, product_[i] * inverse_);
+      BigInteger::AddLimbs(product_.data() + i + size_, size_ + 2 - i, &carry, 1);
+    }
+    reduced = product_.data() + size_;
+  } else if (mask_bits_ != 0) {
+    const size_t top = mask_bits_ / BigInteger::kLimbBits;
+    product_[top] &= (Limb{1} << (mask_bits_ % BigInteger::kLimbBits)) - 1;
+    std::fill(product_.begin() + top + 1, product_.begin() + size_ + 1, 0);
+    reduced = product_.data();
+  } else {
+    // q = floor(floor(x / 2^(64 * (n - 1))) * reciprocal_ / 2^(64 * (n + 1))) is at most two below
+    // floor(x / m), so x - q * m needs only n + 1 limbs and at most two corrections.
+    Limb* estimate = scratch_.data();
+    Limb* multiple = estimate + 2 * size_ + 2;
+    std::fill(estimate, estimate + 2 * size_ + 2, 0);
+    BigInteger::MultiplyLimbs(product_.data() + size_ - 1, size_ + 1, reciprocal_.data(), size_ + 1, estimate);
+    const Limb* quotient = estimate + size_ + 1;
+
+    std::fill(multiple, multiple + 2 * size_ + 1, 0);
+    BigInteger::MultiplyLimbs(quotient, size_ + 1, modulus, size_, multiple);
+    BigInteger::SubtractLimbs(product_.data(), size_ + 1, multiple, size_ + 1);
+    product_[size_ + 1] = 0;
+    reduced = product_.data();
+  }
+
+  // The remainder is below 3 * m (2 * m in Montgomery mode).
+  while (reduced[size_] != 0 || BigInteger::CompareLimbs(reduced, size_, modulus, size_) >= 0) {
+    BigInteger::SubtractLimbs(reduced, size_ + 1, modulus, size_);
+  }
+  Store(reduced, result);
+}
+
+void ModContext::Store(const Limb* limbs, BigInteger& result) const {
+  result.limbs_.Assign(limbs, limbs + size_);
+  result.is_negative_ = false;
+  result.RemoveLeadingZeros();
+}
+
+BinarySplitting::BinarySplitting(Term p, Term q, Term a) : p_(std::move(p)), q_(std::move(q)), a_(std::move(a)) {
+}
+
+SeriesSums BinarySplitting::Evaluate(uint64_t begin, uint64_t end) const {
+  SeriesSums sums;
+  if (end <= begin) {
+    sums.p = BigInteger(1);
+    sums.q = BigInteger(1);
+    return sums;
+  }
+  Split(begin, end, sums);
+  return sums;
+}
+
+void BinarySplitting::Split(uint64_t begin, uint64_t end, SeriesSums& sums) const {
+  if (end - begin == 1) {
+    sums.p = p_(begin);
+    sums.q = q_(begin);
+    sums.t = a_(begin) * sums.p;
+    return;
+  }
+
+  // With the halves [begin, middle) and [middle, end): p = p_l * p_r, q = q_l * q_r and
+  // t = t_l * q_r + p_l * t_r.
+  const uint64_t middle = begin + (end - begin) / 2;
+  SeriesSums halves[2];
+  RunTasks(2, end - begin >= kParallelTerms ? BigInteger::MultiplyThreads() : 1, [&](size_t i) {
+    if (i == 0) {
+      Split(begin, middle, halves[0]);
+    } else {
+      Split(middle, end, halves[1]);
+    }
+  });
+  sums.t = halves[0].t * halves[1].q + halves[0].p * halves[1].t;
+  sums.p = halves[0].p * halves[1].p;
+  sums.q = halves[0].q * halves[1].q;
+}
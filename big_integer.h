@@ -1,104 +1,751 @@
-#pragma once
-
-#define BIG_INTEGER_DIVISION_IMPLEMENTED
-
-#include <iostream>
-#include <vector>
-#include <string>
-#include <stdexcept>
-#include <iomanip>
-#include <algorithm>
-#include <cmath>
-#include <cstdint>
-
-class BigIntegerException : public std::runtime_error {
- public:
-  explicit BigIntegerException(const std::string& msg) : std::runtime_error(msg) {
-  }
-};
-
-class BigIntegerOverflow : public BigIntegerException {
- public:
-  BigIntegerOverflow() : BigIntegerException("BigInteger overflow") {
-  }
-};
-
-class BigIntegerDivisionByZero : public BigIntegerException {
- public:
-  BigIntegerDivisionByZero() : BigIntegerException("Division by zero") {
-  }
-};
-
-class BigInteger {
- private:
-  static constexpr int kBase = 10000;
-  static constexpr int kBaseDigits = 4;
-
-  std::vector<int> digits_;
-  bool is_negative_;
-
-  void Normalize();
-  void ParseString(const std::string& str);
-  void AddDigits(int64_t value);
-  void HandleCarry(size_t index, int& carry);
-  void HandleBorrow(size_t index, int& borrow);
-  void EnsureCapacity(size_t size);
-  void RemoveLeadingZeros();
-  void CheckOverflow(int value) const;
-  void CheckDivision(const BigInteger& divisor) const;
-
-  static void MultiplyHelper(const BigInteger& a, const BigInteger& b, BigInteger& result);
-  static void DivideHelper(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
-                           BigInteger& remainder);
-  static void CompareDigits(const BigInteger& a, const BigInteger& b, int& result);
-
- public:
-  BigInteger();
-  BigInteger(int value);                      // NOLINT
-  BigInteger(int64_t value);                  // NOLINT
-  BigInteger(const std::string& value);       // NOLINT
-  BigInteger(const char* value);              // NOLINT
-
-  BigInteger(const BigInteger&) = default;
-  BigInteger(BigInteger&&) noexcept = default;
-
-  BigInteger& operator=(const BigInteger&) = default;
-  BigInteger& operator=(BigInteger&&) noexcept = default;
-
-  bool IsNegative() const;
-  BigInteger Absolute() const;
-
-  BigInteger operator+() const;
-  BigInteger operator-() const;
-
-  BigInteger& operator+=(const BigInteger& other);
-  BigInteger& operator-=(const BigInteger& other);
-  BigInteger& operator*=(const BigInteger& other);
-  BigInteger& operator/=(const BigInteger& other);
-  BigInteger& operator%=(const BigInteger& other);
-
-  BigInteger& operator++();
-  BigInteger operator++(int);
-  BigInteger& operator--();
-  BigInteger operator--(int);
-
-  explicit operator bool() const;
-
-  friend bool operator==(const BigInteger& a, const BigInteger& b);
-  friend bool operator!=(const BigInteger& a, const BigInteger& b);
-  friend bool operator<(const BigInteger& a, const BigInteger& b);
-  friend bool operator<=(const BigInteger& a, const BigInteger& b);
-  friend bool operator>(const BigInteger& a, const BigInteger& b);
-  friend bool operator>=(const BigInteger& a, const BigInteger& b);
-
-  friend std::ostream& operator<<(std::ostream& os, const BigInteger& value);
-  friend std::istream& operator>>(std::istream& is, BigInteger& value);
-
-  size_t DigitCount() const;
-};
-
-BigInteger operator+(BigInteger a, const BigInteger& b);
-BigInteger operator-(BigInteger a, const BigInteger& b);
-BigInteger operator*(BigInteger a, const BigInteger& b);
-BigInteger operator/(BigInteger a, const BigInteger& b);
-BigInteger operator%(BigInteger a, const BigInteger& b);
+#pragma once
+
+#define BIG_INTEGER_DIVISION_IMPLEMENTED
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <iomanip>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+// Building with BIG_INTEGER_STATISTICS (for the whole program) makes BigInteger record per-operation
+// statistics; otherwise the recording is compiled out.
+#ifdef BIG_INTEGER_STATISTICS
+inline constexpr bool kBigIntegerStatistics = true;
+#else
+inline constexpr bool kBigIntegerStatistics = false;
+#endif
+
+// Building with BIG_INTEGER_UNCHECKED drops the validation of parsed decimal text and the
+// MaxDigitCount() limit, for programs whose inputs are known to be well-formed and of bounded size.
+// The default checked build throws BigIntegerOverflow for both.
+#ifdef BIG_INTEGER_UNCHECKED
+inline constexpr bool kBigIntegerChecked = false;
+#else
+inline constexpr bool kBigIntegerChecked = true;
+#endif
+
+// Called by SmallBuffer for each heap allocation when built with BIG_INTEGER_STATISTICS; the count
+// is read through BigInteger::StatisticsSnapshot().
+void CountSmallBufferAllocation();
+
+class BigIntegerException : public std::runtime_error {
+ public:
+  explicit BigIntegerException(const std::string& msg) : std::runtime_error(msg) {
+  }
+};
+
+class BigIntegerOverflow : public BigIntegerException {
+ public:
+  BigIntegerOverflow() : BigIntegerException("BigInteger overflow") {
+  }
+};
+
+class BigIntegerDivisionByZero : public BigIntegerException {
+ public:
+  BigIntegerDivisionByZero() : BigIntegerException("Division by zero") {
+  }
+};
+
+// Contiguous storage for trivially copyable elements. Up to InlineCapacity elements live inside
+// the object itself; the buffer moves to the heap only when it grows past that.
+template <typename T, size_t InlineCapacity>
+class SmallBuffer {
+  static_assert(std::is_trivially_copyable_v<T>, "SmallBuffer relocates elements with memcpy");
+
+ public:
+  using SizeType = size_t;
+  using Iterator = T*;
+  using ConstIterator = const T*;
+
+  SmallBuffer() noexcept = default;
+
+  SmallBuffer(const SmallBuffer& other) {
+    Assign(other.begin(), other.end());
+  }
+
+  SmallBuffer(SmallBuffer&& other) noexcept {
+    StealFrom(other);
+  }
+
+  SmallBuffer& operator=(const SmallBuffer& other) {
+    if (this != &other) {
+      Assign(other.begin(), other.end());
+    }
+    return *this;
+  }
+
+  SmallBuffer& operator=(SmallBuffer&& other) noexcept {
+    if (this != &other) {
+      Deallocate();
+      StealFrom(other);
+    }
+    return *this;
+  }
+
+  ~SmallBuffer() {
+    Deallocate();
+  }
+
+  SizeType Size() const noexcept {
+    return size_;
+  }
+  SizeType Capacity() const noexcept {
+    return capacity_;
+  }
+  bool Empty() const noexcept {
+    return size_ == 0;
+  }
+  bool IsInline() const noexcept {
+    return data_ == inline_;
+  }
+
+  T& operator[](SizeType idx) {
+    return data_[idx];
+  }
+  const T& operator[](SizeType idx) const {
+    return data_[idx];
+  }
+  T& Back() {
+    return data_[size_ - 1];
+  }
+  const T& Back() const {
+    return data_[size_ - 1];
+  }
+  T* Data() noexcept {
+    return data_;
+  }
+  const T* Data() const noexcept {
+    return data_;
+  }
+
+  Iterator begin() noexcept {  // NOLINT
+    return data_;
+  }
+  Iterator end() noexcept {  // NOLINT
+    return data_ + size_;
+  }
+  ConstIterator begin() const noexcept {  // NOLINT
+    return data_;
+  }
+  ConstIterator end() const noexcept {  // NOLINT
+    return data_ + size_;
+  }
+
+  void Reserve(SizeType new_cap) {
+    if (new_cap <= capacity_) {
+      return;
+    }
+    if (new_cap > kMaxSize) {
+      throw std::length_error("SmallBuffer size exceeds 2^32 - 1 elements");
+    }
+    auto new_data = static_cast<T*>(::operator new(new_cap * sizeof(T)));
+    if constexpr (kBigIntegerStatistics) {
+      CountSmallBufferAllocation();
+    }
+    if (size_ > 0) {
+      std::memcpy(new_data, data_, size_ * sizeof(T));
+    }
+    Deallocate();
+    data_ = new_data;
+    capacity_ = static_cast<uint32_t>(new_cap);
+  }
+
+  void Resize(SizeType new_size, T value = T()) {
+    if (new_size > capacity_) {
+      Reserve(GrownCapacity(new_size));
+    }
+    std::fill(data_ + std::min<SizeType>(size_, new_size), data_ + new_size, value);
+    size_ = static_cast<uint32_t>(new_size);
+  }
+
+  void Assign(SizeType count, T value) {
+    size_ = 0;
+    Resize(count, value);
+  }
+
+  void Assign(const T* first, const T* last) {
+    auto count = static_cast<SizeType>(last - first);
+    if (count > capacity_) {
+      size_ = 0;
+      Reserve(count);
+    }
+    if (count > 0) {
+      std::memmove(data_, first, count * sizeof(T));
+    }
+    size_ = static_cast<uint32_t>(count);
+  }
+
+  void Insert(SizeType idx, SizeType count, T value) {
+    SizeType old_size = size_;
+    if (old_size + count > capacity_) {
+      Reserve(GrownCapacity(old_size + count));
+    }
+    std::memmove(data_ + idx + count, data_ + idx, (old_size - idx) * sizeof(T));
+    std::fill(data_ + idx, data_ + idx + count, value);
+    size_ = static_cast<uint32_t>(old_size + count);
+  }
+
+  void PushBack(T value) {
+    if (size_ == capacity_) {
+      Reserve(GrownCapacity(SizeType{size_} + 1));
+    }
+    data_[size_++] = value;
+  }
+
+  void PopBack() {
+    --size_;
+  }
+
+  void Clear() noexcept {
+    size_ = 0;
+  }
+
+ private:
+  static constexpr SizeType kMaxSize = UINT32_MAX;
+
+  T* data_ = inline_;
+  uint32_t size_ = 0;
+  uint32_t capacity_ = InlineCapacity;
+  T inline_[InlineCapacity];
+
+  // Doubles the capacity, computed in SizeType so that it cannot wrap, but stops at kMaxSize; Reserve
+  // rejects required sizes beyond that.
+  SizeType GrownCapacity(SizeType required) const {
+    return std::max(required, std::min<SizeType>(2 * SizeType{capacity_}, kMaxSize));
+  }
+
+  void Deallocate() noexcept {
+    if (data_ != inline_) {
+      ::operator delete(data_);
+      data_ = inline_;
+      capacity_ = InlineCapacity;
+    }
+  }
+
+  void StealFrom(SmallBuffer& other) noexcept {
+    if (other.data_ == other.inline_) {
+      std::memcpy(inline_, other.inline_, other.size_ * sizeof(T));
+      data_ = inline_;
+      capacity_ = InlineCapacity;
+    } else {
+      data_ = other.data_;
+      capacity_ = other.capacity_;
+      other.data_ = other.inline_;
+      other.capacity_ = InlineCapacity;
+    }
+    size_ = other.size_;
+    other.size_ = 0;
+  }
+};
+
+class BigInteger {
+ public:
+  // Multiplication tiers. kAuto picks the tier from the size of the smaller operand;
+  // forcing a tier only affects the top level, recursive sub-products are dispatched automatically.
+  enum class MultiplyAlgorithm { kAuto, kSchoolbook, kKaratsuba, kToom3, kToom4, kNtt };
+  // Instruction sets for the limb kernels (add/subtract, multiply-accumulate rows, comparison). kAvx2 and
+  // kAvx512 also take MULX/ADX rows when the CPU has them.
+  enum class KernelSet { kScalar, kAvx2, kAvx512 };
+  // Operation kinds and algorithm tiers of the statistics. Native operands count under the same kinds
+  // as BigInteger ones; kIncrement covers ++ and --. kSubquadratic is the recursive tier of division
+  // (Burnikel-Ziegler) and of decimal conversion.
+  enum class Operation { kParse, kPrint, kAdd, kSubtract, kMultiply, kSquare, kDivide, kCompare, kIncrement };
+  enum class Tier { kBasecase, kKaratsuba, kToom3, kToom4, kNtt, kSubquadratic };
+  static constexpr size_t kOperationCount = 9;
+  static constexpr size_t kTierCount = 6;
+  // Bucket k of the size histogram counts operands of [2^(k - 1), 2^k) limbs; bucket 0 counts zero.
+  static constexpr size_t kSizeBuckets = 34;
+
+  // Totals for one operation kind. An operation's size is that of its larger operand in limbs (in
+  // 19-digit chunks for kParse). Only the outermost operation is recorded: the additions inside a
+  // Toom product or the divisions of a print count toward that product or print alone, including
+  // their time and allocations. Functions without a kind of their own, such as Gcd or PowMod,
+  // record the operations they make. Only heap allocations of limb buffers on the calling thread
+  // count.
+  struct OperationStatistics {
+    uint64_t calls = 0;
+    uint64_t limbs = 0;
+    uint64_t allocations = 0;
+    uint64_t nanoseconds = 0;
+    std::array<uint64_t, kTierCount> tiers{};
+    std::array<uint64_t, kSizeBuckets> sizes{};
+  };
+  using Statistics = std::array<OperationStatistics, kOperationCount>;
+
+ private:
+  using Limb = uint64_t;
+
+  static constexpr int kLimbBits = 64;
+  // Magnitudes below 2^128, which covers any product of two native operands; additions spill past
+  // them only when a carry leaves the top limb.
+  static constexpr size_t kInlineLimbs = 2;
+  // Largest power of ten below 2^64; decimal text is converted in chunks of kDecimalBaseDigits digits.
+  static constexpr Limb kDecimalBase = 10'000'000'000'000'000'000ULL;
+  static constexpr int kDecimalBaseDigits = 19;
+  // Up to this many limbs (or decimal chunks) conversion uses the quadratic loop instead of divide and conquer.
+  static constexpr size_t kDecimalThreshold = 32;
+  // Product trees multiply up to this many native factors straight into one value.
+  static constexpr size_t kProductTreeLeaf = 16;
+
+  // Selects the overloads for unsigned native operands, which would wrap to negative values above
+  // INT64_MAX if they converted to int64_t.
+  template <typename T>
+  using IfUnsigned = std::enable_if_t<std::is_unsigned_v<T> && !std::is_same_v<T, bool>, int>;
+
+  SmallBuffer<Limb, kInlineLimbs> limbs_;
+  bool is_negative_;
+
+  void Normalize();
+  void ParseString(const std::string& str);
+  void AddLimb(uint64_t value);
+  void RemoveLeadingZeros();
+  void CheckDivision(const BigInteger& divisor) const;
+  void AddSigned(const BigInteger& other, bool other_negative);
+  void AddNative(uint64_t magnitude, bool negative);
+  void MultiplyByNative(uint64_t magnitude);
+  uint64_t DivideByNative(uint64_t magnitude);
+  void ShiftLeft(size_t bits);
+  void ShiftRight(size_t bits);
+  BigInteger& AddOperand(uint64_t magnitude, bool negative, Operation operation);
+  BigInteger& MultiplyOperand(uint64_t magnitude, bool negative);
+  BigInteger& DivideOperand(uint64_t magnitude, bool negative);
+  BigInteger& ModuloOperand(uint64_t magnitude);
+  int CompareWith(uint64_t magnitude, bool negative) const;
+  bool ExceedsDigitCount(size_t limit) const;
+
+  static size_t karatsuba_threshold_;
+  static size_t toom3_threshold_;
+  static size_t toom4_threshold_;
+  static size_t ntt_threshold_;
+  static size_t max_digit_count_;
+  static size_t divide_threshold_;
+  static size_t gcd_threshold_;
+  // Read by worker threads while another thread may change them.
+  static std::atomic<size_t> multiply_threads_;
+  static std::atomic<size_t> parallel_threshold_;
+
+  struct GcdMatrix;
+
+  static void MultiplyHelper(const BigInteger& a, const BigInteger& b, BigInteger& result,
+                             MultiplyAlgorithm algorithm = MultiplyAlgorithm::kAuto);
+  static MultiplyAlgorithm SelectMultiplyAlgorithm(size_t a_size, size_t b_size);
+  static void MultiplyWith(MultiplyAlgorithm algorithm, const Limb* a, size_t a_size, const Limb* b, size_t b_size,
+                           Limb* result);
+  static void MultiplyLimbs(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result);
+  static void SchoolbookMultiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result);
+  static void SchoolbookSquare(const Limb* a, size_t size, Limb* result);
+  static void KaratsubaMultiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result);
+  static void Toom3Multiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result);
+  static void Toom4Multiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result);
+  static void NttMultiply(const Limb* a, size_t a_size, const Limb* b, size_t b_size, Limb* result);
+  static BigInteger MultiplyParts(const BigInteger& a, const BigInteger& b);
+  static BigInteger SliceLimbs(const Limb* limbs, size_t size, size_t begin, size_t length);
+  static void AccumulateShifted(Limb* target, size_t target_size, const BigInteger& value, size_t shift);
+  static Limb AddLimbs(Limb* target, size_t target_size, const Limb* source, size_t source_size);
+  static void SubtractLimbs(Limb* target, size_t target_size, const Limb* source, size_t source_size);
+  static void ReverseSubtractLimbs(Limb* target, const Limb* source, size_t size);
+  static void DivideHelper(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                           BigInteger& remainder);
+  static void SchoolbookDivide(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                               BigInteger& remainder);
+  static void BurnikelZieglerDivide(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                                    BigInteger& remainder);
+  static void DivideTwoByOne(const BigInteger& dividend, const BigInteger& divisor, size_t size, BigInteger& quotient,
+                             BigInteger& remainder);
+  static void DivideThreeByTwo(const BigInteger& dividend, const BigInteger& divisor, size_t size,
+                               BigInteger& quotient, BigInteger& remainder);
+  static BigInteger ShiftLimbs(const BigInteger& value, size_t shift);
+  static void KnuthDivide(const Limb* dividend, size_t dividend_size, const Limb* divisor, size_t divisor_size,
+                          Limb* quotient, Limb* remainder);
+  static void CompareDigits(const BigInteger& a, const BigInteger& b, int& result);
+  static int CompareLimbs(const Limb* a, size_t a_size, const Limb* b, size_t b_size);
+  static BigInteger ParseDecimal(const Limb* chunks, size_t count, const std::vector<BigInteger>& powers);
+  static void AppendDecimal(const BigInteger& magnitude, size_t width, const std::vector<BigInteger>& powers,
+                            std::string& out);
+  static BigInteger PowerOfTen(size_t exponent);
+  static BigInteger NewtonRoot(const BigInteger& value, uint64_t k);
+  static BigInteger ProductTree(const uint64_t* factors, size_t count);
+  static BigInteger RangeProductTree(uint64_t lo, uint64_t hi);
+  static BigInteger GcdHelper(BigInteger a, BigInteger b, BigInteger* cofactor);
+  static bool HalfGcd(BigInteger& a, BigInteger& b, GcdMatrix& matrix);
+  static bool ReduceByLeadingLimbs(BigInteger& a, BigInteger& b, size_t shift, GcdMatrix& matrix);
+  static void LehmerReduce(BigInteger& a, BigInteger& b, size_t floor_bits, size_t stop_bits, GcdMatrix& matrix);
+  static Limb TopBits(const BigInteger& value, size_t shift);
+  static void ApplyCofactors(BigInteger& a, BigInteger& b, int64_t m00, int64_t m01, int64_t m10, int64_t m11);
+
+  friend class ModContext;
+
+ public:
+  BigInteger();
+  BigInteger(int value);                      // NOLINT
+  BigInteger(int64_t value);                  // NOLINT
+  BigInteger(const std::string& value);       // NOLINT
+  BigInteger(const char* value);              // NOLINT
+
+  BigInteger(const BigInteger&) = default;
+  BigInteger(BigInteger&&) noexcept = default;
+
+  BigInteger& operator=(const BigInteger&) = default;
+  BigInteger& operator=(BigInteger&&) noexcept = default;
+
+  bool IsNegative() const;
+  BigInteger Absolute() const;
+
+  BigInteger operator+() const;
+  BigInteger operator-() const;
+
+  BigInteger& operator+=(const BigInteger& other);
+  BigInteger& operator-=(const BigInteger& other);
+  BigInteger& operator*=(const BigInteger& other);
+  BigInteger& operator/=(const BigInteger& other);
+  BigInteger& operator%=(const BigInteger& other);
+
+  // Native operands work on the limbs directly and do not allocate unless the value grows. Unsigned
+  // operands have overloads of their own and keep their full range.
+  BigInteger& operator+=(int64_t other);
+  BigInteger& operator-=(int64_t other);
+  BigInteger& operator*=(int64_t other);
+  BigInteger& operator/=(int64_t other);
+  BigInteger& operator%=(int64_t other);
+  template <typename T, IfUnsigned<T> = 0>
+  BigInteger& operator+=(T other) {
+    return AddOperand(other, false, Operation::kAdd);
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  BigInteger& operator-=(T other) {
+    return AddOperand(other, true, Operation::kSubtract);
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  BigInteger& operator*=(T other) {
+    return MultiplyOperand(other, false);
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  BigInteger& operator/=(T other) {
+    return DivideOperand(other, false);
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  BigInteger& operator%=(T other) {
+    return ModuloOperand(other);
+  }
+
+  // Shifts multiply by 2^shift and divide by it rounding toward minus infinity; &, |, ^ and ~ act on
+  // the two's complement form with infinite sign extension, so ~x = -x - 1.
+  BigInteger& operator<<=(size_t shift);
+  BigInteger& operator>>=(size_t shift);
+  BigInteger& operator&=(const BigInteger& other);
+  BigInteger& operator|=(const BigInteger& other);
+  BigInteger& operator^=(const BigInteger& other);
+  BigInteger operator~() const;
+
+  // BitLength and PopCount describe the magnitude (BitLength of 0 is 0); TestBit reads the two's
+  // complement form. CountTrailingZeros is the same for both and 0 for 0.
+  size_t BitLength() const;
+  size_t PopCount() const;
+  bool TestBit(size_t index) const;
+  size_t CountTrailingZeros() const;
+
+  // Replaces *this with the truncated quotient and stores the remainder, from a single division.
+  BigInteger& DivideWithRemainder(const BigInteger& divisor, BigInteger& remainder);
+  int64_t DivideWithRemainder(int64_t divisor);
+  // The remainder of an unsigned divisor need not fit in int64_t.
+  template <typename T, IfUnsigned<T> = 0>
+  int64_t DivideWithRemainder(T divisor) = delete;
+
+  BigInteger& operator++();
+  BigInteger operator++(int);
+  BigInteger& operator--();
+  BigInteger operator--(int);
+
+  explicit operator bool() const;
+
+  friend bool operator==(const BigInteger& a, const BigInteger& b);
+  friend bool operator!=(const BigInteger& a, const BigInteger& b);
+  friend bool operator<(const BigInteger& a, const BigInteger& b);
+  friend bool operator<=(const BigInteger& a, const BigInteger& b);
+  friend bool operator>(const BigInteger& a, const BigInteger& b);
+  friend bool operator>=(const BigInteger& a, const BigInteger& b);
+
+  friend bool operator==(const BigInteger& a, int64_t b);
+  friend bool operator!=(const BigInteger& a, int64_t b);
+  friend bool operator<(const BigInteger& a, int64_t b);
+  friend bool operator<=(const BigInteger& a, int64_t b);
+  friend bool operator>(const BigInteger& a, int64_t b);
+  friend bool operator>=(const BigInteger& a, int64_t b);
+  friend bool operator==(int64_t a, const BigInteger& b);
+  friend bool operator!=(int64_t a, const BigInteger& b);
+  friend bool operator<(int64_t a, const BigInteger& b);
+  friend bool operator<=(int64_t a, const BigInteger& b);
+  friend bool operator>(int64_t a, const BigInteger& b);
+  friend bool operator>=(int64_t a, const BigInteger& b);
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator==(const BigInteger& a, T b) {
+    return a.CompareWith(b, false) == 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator!=(const BigInteger& a, T b) {
+    return a.CompareWith(b, false) != 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator<(const BigInteger& a, T b) {
+    return a.CompareWith(b, false) < 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator<=(const BigInteger& a, T b) {
+    return a.CompareWith(b, false) <= 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator>(const BigInteger& a, T b) {
+    return a.CompareWith(b, false) > 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator>=(const BigInteger& a, T b) {
+    return a.CompareWith(b, false) >= 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator==(T a, const BigInteger& b) {
+    return b.CompareWith(a, false) == 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator!=(T a, const BigInteger& b) {
+    return b.CompareWith(a, false) != 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator<(T a, const BigInteger& b) {
+    return b.CompareWith(a, false) > 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator<=(T a, const BigInteger& b) {
+    return b.CompareWith(a, false) >= 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator>(T a, const BigInteger& b) {
+    return b.CompareWith(a, false) < 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend bool operator>=(T a, const BigInteger& b) {
+    return b.CompareWith(a, false) <= 0;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator+(BigInteger a, T b) {
+    return a += b;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator+(T a, BigInteger b) {
+    return b += a;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator-(BigInteger a, T b) {
+    return a -= b;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator*(BigInteger a, T b) {
+    return a *= b;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator*(T a, BigInteger b) {
+    return b *= a;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator/(BigInteger a, T b) {
+    return a /= b;
+  }
+  template <typename T, IfUnsigned<T> = 0>
+  friend BigInteger operator%(BigInteger a, T b) {
+    return a %= b;
+  }
+
+  friend std::ostream& operator<<(std::ostream& os, const BigInteger& value);
+  friend std::istream& operator>>(std::istream& is, BigInteger& value);
+
+  size_t DigitCount() const;
+
+  static BigInteger Multiply(const BigInteger& a, const BigInteger& b,
+                             MultiplyAlgorithm algorithm = MultiplyAlgorithm::kAuto);
+  // value * value; every tier shares the work of the symmetric cross products. Multiply, operator*
+  // and operator*= take the same path when both operands are the same object.
+  static BigInteger Square(const BigInteger& value, MultiplyAlgorithm algorithm = MultiplyAlgorithm::kAuto);
+
+  // Truncated quotient and remainder (the remainder takes the sign of the dividend) from one division.
+  // The output arguments may alias the inputs but must be distinct objects.
+  static std::pair<BigInteger, BigInteger> DivMod(const BigInteger& dividend, const BigInteger& divisor);
+  static void DivMod(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient,
+                     BigInteger& remainder);
+
+  // base^exponent, with 0^0 = 1.
+  static BigInteger Pow(const BigInteger& base, uint64_t exponent);
+  // base^exponent reduced into [0, |modulus|) for a non-negative exponent, by sliding-window
+  // exponentiation in a ModContext.
+  static BigInteger PowMod(const BigInteger& base, const BigInteger& exponent, const BigInteger& modulus);
+
+  // n!, C(n, k) (0 for k > n) and lo * (lo + 1) * ... * hi (1 for hi < lo), each multiplied as a
+  // balanced product tree. Factorial multiplies prime powers by the prime-swing recursion and
+  // Binomial the prime factorization of the result, so nearly all the work is in large balanced
+  // products. Results beyond MaxDigitCount() throw BigIntegerOverflow, clearly oversized ones before
+  // any sieving or multiplication.
+  static BigInteger Factorial(uint64_t n);
+  static BigInteger Binomial(uint64_t n, uint64_t k);
+  static BigInteger ProductRange(uint64_t lo, uint64_t hi);
+
+  // floor(value^(1/k)) of a non-negative value by Newton iteration with precision doubling; for odd k
+  // a negative value has root -Root(-value, k). Throws BigIntegerException for k = 0 and for even
+  // roots of negative values.
+  static BigInteger Sqrt(const BigInteger& value);
+  static BigInteger Root(const BigInteger& value, uint64_t k);
+  // Sqrt(value) and value - Sqrt(value)^2.
+  static std::pair<BigInteger, BigInteger> SqrtRem(const BigInteger& value);
+  // Square residue tests modulo 256 and seven divisors of 2^48 - 1 reject all but about 0.05% of
+  // non-squares with one pass over the limbs; only the rest take a square root.
+  static bool IsPerfectSquare(const BigInteger& value);
+
+  // Non-negative gcd and lcm by Lehmer's algorithm, with a subquadratic half-gcd reduction while the
+  // smaller operand has at least GcdThreshold() limbs; Gcd(0, 0) = 0.
+  static BigInteger Gcd(const BigInteger& a, const BigInteger& b);
+  static BigInteger Lcm(const BigInteger& a, const BigInteger& b);
+  // Returns Gcd(a, b) and sets x and y with a * x + b * y = Gcd(a, b).
+  static BigInteger ExtendedGcd(const BigInteger& a, const BigInteger& b, BigInteger& x, BigInteger& y);
+  // The inverse of a modulo |modulus| in [0, |modulus|); throws BigIntegerException if there is none.
+  static BigInteger ModInverse(const BigInteger& a, const BigInteger& modulus);
+
+  // Minimal size (in limbs) of the smaller operand for which kAuto selects the given tier.
+  static size_t MultiplyThreshold(MultiplyAlgorithm algorithm);
+  static void SetMultiplyThreshold(MultiplyAlgorithm algorithm, size_t limbs);
+
+  // Products with more decimal digits than this throw BigIntegerOverflow (not enforced with
+  // BIG_INTEGER_UNCHECKED).
+  static size_t MaxDigitCount();
+  static void SetMaxDigitCount(size_t digits);
+
+  // Minimal divisor size (in limbs) for which division switches to the Burnikel-Ziegler recursion.
+  static size_t DivideThreshold();
+  static void SetDivideThreshold(size_t limbs);
+
+  // Minimal operand size (in limbs) for which Gcd, ExtendedGcd and ModInverse use the half-gcd recursion.
+  static size_t GcdThreshold();
+  static void SetGcdThreshold(size_t limbs);
+
+  // Threads a product may use, the calling one included (1 by default; 0 selects the hardware
+  // concurrency). Products of operands with at least ParallelThreshold() limbs run the pointwise
+  // products of the Toom tiers or the three NTT convolutions on extra threads, as long as fewer than
+  // MultiplyThreads() - 1 are busy process-wide. The result does not depend on the thread count.
+  static size_t MultiplyThreads();
+  static void SetMultiplyThreads(size_t threads);
+  static size_t ParallelThreshold();
+  static void SetParallelThreshold(size_t limbs);
+
+  // The kernel set in use. At startup it is the best one the CPU supports, capped by the
+  // BIG_INTEGER_KERNELS environment variable (scalar, avx2 or avx512); SetKernels applies a new cap
+  // and may be called while other threads compute.
+  static KernelSet Kernels();
+  static void SetKernels(KernelSet limit);
+
+  // Statistics of all threads since startup or the last reset, indexed by Operation; all zero unless
+  // built with BIG_INTEGER_STATISTICS. Snapshots taken while other threads compute are not atomic
+  // as a whole. The names are lower-case identifiers for exporting the counters.
+  static Statistics StatisticsSnapshot();
+  static void ResetStatistics();
+  static const char* OperationName(Operation operation);
+  static const char* TierName(Tier tier);
+};
+
+BigInteger operator+(BigInteger a, const BigInteger& b);
+BigInteger operator-(BigInteger a, const BigInteger& b);
+BigInteger operator*(const BigInteger& a, const BigInteger& b);
+BigInteger operator/(BigInteger a, const BigInteger& b);
+BigInteger operator%(BigInteger a, const BigInteger& b);
+
+BigInteger operator<<(BigInteger a, size_t shift);
+BigInteger operator>>(BigInteger a, size_t shift);
+BigInteger operator&(BigInteger a, const BigInteger& b);
+BigInteger operator|(BigInteger a, const BigInteger& b);
+BigInteger operator^(BigInteger a, const BigInteger& b);
+
+BigInteger operator+(BigInteger a, int64_t b);
+BigInteger operator+(int64_t a, BigInteger b);
+BigInteger operator-(BigInteger a, int64_t b);
+BigInteger operator*(BigInteger a, int64_t b);
+BigInteger operator*(int64_t a, BigInteger b);
+BigInteger operator/(BigInteger a, int64_t b);
+BigInteger operator%(BigInteger a, int64_t b);
+
+// Precomputed reduction modulo a fixed |modulus|: Montgomery for odd moduli, Barrett otherwise.
+// Residues live in [0, |modulus|) in the context's form (Montgomery form x * 2^(64 * n) mod m for odd
+// moduli, plain residues otherwise); the checked build throws BigIntegerException for operands outside
+// [0, |modulus|). Outputs may alias the inputs. The operations reuse buffers owned
+// by the context, so a context must not be shared between threads; for moduli below the Karatsuba
+// threshold they do not allocate once the result has enough capacity.
+class ModContext {
+ public:
+  explicit ModContext(const BigInteger& modulus);
+
+  const BigInteger& Modulus() const;
+  bool IsMontgomery() const;
+
+  // Reduce any value into the context's form and back; for even moduli these are plain reductions.
+  void ToMontgomery(const BigInteger& value, BigInteger& result) const;
+  void FromMontgomery(const BigInteger& value, BigInteger& result) const;
+
+  void AddMod(const BigInteger& a, const BigInteger& b, BigInteger& result) const;
+  void SubMod(const BigInteger& a, const BigInteger& b, BigInteger& result) const;
+  void MulMod(const BigInteger& a, const BigInteger& b, BigInteger& result) const;
+  void SqrMod(const BigInteger& a, BigInteger& result) const;
+
+ private:
+  using Limb = BigInteger::Limb;
+
+  BigInteger modulus_;
+  size_t size_;
+  bool montgomery_;
+  Limb inverse_;
+  // For moduli 2^mask_bits_ reduction keeps the low mask_bits_ bits instead of using reciprocal_; 0
+  // for other moduli.
+  size_t mask_bits_;
+  BigInteger r_squared_;
+  std::vector<Limb> reciprocal_;
+  mutable std::vector<Limb> product_;
+  mutable std::vector<Limb> scratch_;
+
+  void CheckResidue(const BigInteger& value) const;
+  void Reduce(BigInteger& result) const;
+  void Store(const Limb* limbs, BigInteger& result) const;
+};
+
+// Binary-splitting sums over [begin, end) of a(n) * p(begin) ... p(n) / (q(begin) ... q(n)):
+// p and q are the products of p(n) and q(n) over the range and t / q is the partial sum.
+struct SeriesSums {
+  BigInteger p;
+  BigInteger q;
+  BigInteger t;
+};
+
+// Evaluates hypergeometric-type series from integer term generators by binary splitting, so the
+// work is a tree of balanced products instead of one growing sum. The two halves of a range of at
+// least kParallelTerms terms run on separate threads within BigInteger::MultiplyThreads(); the
+// generators must then be safe to call concurrently.
+class BinarySplitting {
+ public:
+  using Term = std::function<BigInteger(uint64_t)>;
+
+  BinarySplitting(Term p, Term q, Term a);
+
+  // p = q = 1 and t = 0 for an empty range.
+  SeriesSums Evaluate(uint64_t begin, uint64_t end) const;
+
+ private:
+  static constexpr uint64_t kParallelTerms = 256;
+
+  Term p_;
+  Term q_;
+  Term a_;
+
+  void Split(uint64_t begin, uint64_t end, SeriesSums& sums) const;
+};
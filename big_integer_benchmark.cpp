@@ -0,0 +1,289 @@
+// Throughput of the BigInteger operations over operand sizes from one limb to a million digits, and
+// of pi to the same number of digits by binary splitting as a macro benchmark.
+//
+//   big_integer_benchmark [--max-digits N] [--min-time-ms T] [--csv FILE] [--json FILE]
+//                         [--baseline FILE] [--tolerance F]
+//
+// Results go to stdout as CSV (and to --csv / --json when given). With --baseline, a CSV from an
+// earlier run, every case slower than the baseline by more than the tolerance (0.1 by default) is
+// reported and the exit code is 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "big_integer.h"
+
+namespace {
+
+struct Result {
+  std::string op;
+  std::string shape;
+  size_t digits;
+  size_t a_digits;
+  size_t b_digits;
+  size_t iterations;
+  double ns_per_op;
+};
+
+struct Options {
+  size_t max_digits = 1000000;
+  double min_time_ms = 100;
+  std::string csv;
+  std::string json;
+  std::string baseline;
+  double tolerance = 0.1;
+};
+
+// Keeps the results of the timed operations observable. C++20 deprecates compound assignment to a
+// volatile object, so Keep reads and writes it separately.
+volatile size_t sink = 0;
+
+void Keep(size_t value) {
+  sink = sink + value;
+}
+
+// floor(pi * 10^digits) up to a few units in the last place, by binary splitting of the Chudnovsky
+// series: nearly all the time goes into large balanced products and one division.
+BigInteger ChudnovskyPi(size_t digits) {
+  BinarySplitting series(
+      [](uint64_t n) {
+        auto k = static_cast<int64_t>(n);
+        return n == 0 ? BigInteger(1) : BigInteger(-(6 * k - 5)) * (2 * k - 1) * (6 * k - 1);
+      },
+      [](uint64_t n) {
+        auto k = static_cast<int64_t>(n);
+        return n == 0 ? BigInteger(1) : BigInteger(k * k * k) * 10939058860032000;
+      },
+      [](uint64_t n) { return BigInteger(13591409 + 545140134 * static_cast<int64_t>(n)); });
+  // Each term adds a little over 14 digits.
+  SeriesSums sums = series.Evaluate(0, digits / 14 + 2);
+  BigInteger root = BigInteger::Sqrt(BigInteger::Pow(BigInteger(10), 2 * digits) * 10005);
+  return root * 426880 * sums.q / sums.t;
+}
+
+std::string RandomDigits(std::mt19937_64& rng, size_t digits) {
+  std::string str(digits, '0');
+  std::uniform_int_distribution<int> digit(0, 9);
+  for (auto& c : str) {
+    c = static_cast<char>('0' + digit(rng));
+  }
+  str[0] = static_cast<char>('1' + digit(rng) % 9);
+  return str;
+}
+
+// Runs op in batches of doubling size until one batch takes min_time_ms, then reports the best of
+// three batches of that size.
+double Measure(const std::function<void()>& op, double min_time_ms, size_t& iterations) {
+  using Clock = std::chrono::steady_clock;
+  auto run = [&op](size_t count) {
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      op();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+  };
+  iterations = 1;
+  double elapsed = run(iterations);
+  while (elapsed < min_time_ms * 1e6) {
+    iterations *= 2;
+    elapsed = run(iterations);
+  }
+  for (int i = 0; i < 2; ++i) {
+    elapsed = std::min(elapsed, run(iterations));
+  }
+  return elapsed / static_cast<double>(iterations);
+}
+
+void Sweep(const Options& options, std::vector<Result>& results) {
+  std::mt19937_64 rng(20240601);
+  std::vector<size_t> sizes = {19, 100, 1000, 10000, 100000, 1000000};
+
+  for (size_t digits : sizes) {
+    if (digits > options.max_digits) {
+      break;
+    }
+    auto add = [&](const std::string& op, const std::string& shape, size_t a_digits, size_t b_digits,
+                   const std::function<void()>& body) {
+      Result result{op, shape, digits, a_digits, b_digits, 0, 0};
+      result.ns_per_op = Measure(body, options.min_time_ms, result.iterations);
+      results.push_back(result);
+      std::cerr << op << ' ' << shape << ' ' << digits << ": " << result.ns_per_op << " ns\n";
+    };
+
+    // Unbalanced operands pair an n-digit value with one of n / 16 digits; balanced division divides
+    // 2n digits by n so that the quotient has n digits as well.
+    const size_t small_digits = std::max<size_t>(digits / 16, 1);
+    const std::string text = RandomDigits(rng, digits);
+    const BigInteger a(text);
+    const BigInteger b(RandomDigits(rng, digits));
+    const BigInteger small(RandomDigits(rng, small_digits));
+    const BigInteger wide(RandomDigits(rng, 2 * digits));
+    const BigInteger a_copy = a + 0;
+
+    add("parse", "unary", digits, 0, [&] { Keep(BigInteger(text).IsNegative()); });
+    add("print", "unary", digits, 0, [&] {
+      std::ostringstream oss;
+      oss << a;
+      Keep(oss.str().size());
+    });
+
+    add("add", "balanced", digits, digits, [&] { Keep((a + b).IsNegative()); });
+    add("add", "unbalanced", digits, small_digits, [&] { Keep((a + small).IsNegative()); });
+    add("subtract", "balanced", digits, digits, [&] { Keep((a - b).IsNegative()); });
+    add("subtract", "unbalanced", digits, small_digits, [&] { Keep((a - small).IsNegative()); });
+    add("multiply", "balanced", digits, digits, [&] { Keep((a * b).IsNegative()); });
+    add("multiply", "unbalanced", digits, small_digits, [&] { Keep((a * small).IsNegative()); });
+    add("divide", "balanced", 2 * digits, digits, [&] { Keep((wide / a).IsNegative()); });
+    add("divide", "unbalanced", digits, small_digits, [&] { Keep((a / small).IsNegative()); });
+    add("modulo", "balanced", 2 * digits, digits, [&] { Keep((wide % a).IsNegative()); });
+    add("modulo", "unbalanced", digits, small_digits, [&] { Keep((a % small).IsNegative()); });
+
+    // Equal values force a scan over every limb; different lengths are decided by the sizes alone.
+    add("compare", "balanced", digits, digits, [&] { Keep((a < a_copy)); });
+    add("compare", "unbalanced", digits, small_digits, [&] { Keep((a < small)); });
+
+    BigInteger counter = a;
+    add("increment", "unary", digits, 0, [&] { Keep((++counter).IsNegative()); });
+
+    if (ChudnovskyPi(digits) / BigInteger::Pow(BigInteger(10), digits - 10) != BigInteger(31415926535)) {
+      std::cerr << "pi to " << digits << " digits is wrong\n";
+      std::exit(2);
+    }
+    add("pi", "unary", digits, 0, [&] { Keep(ChudnovskyPi(digits).IsNegative()); });
+  }
+}
+
+std::string Key(const std::string& op, const std::string& shape, size_t digits) {
+  return op + ',' + shape + ',' + std::to_string(digits);
+}
+
+void WriteCsv(std::ostream& os, const std::vector<Result>& results) {
+  os << "op,shape,digits,a_digits,b_digits,iterations,ns_per_op\n";
+  for (const auto& r : results) {
+    os << r.op << ',' << r.shape << ',' << r.digits << ',' << r.a_digits << ',' << r.b_digits << ','
+       << r.iterations << ',' << std::fixed << std::setprecision(1) << r.ns_per_op << '\n';
+  }
+}
+
+void WriteJson(std::ostream& os, const std::vector<Result>& results) {
+  os << "[\n";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    os << "  {\"op\": \"" << r.op << "\", \"shape\": \"" << r.shape << "\", \"digits\": " << r.digits
+       << ", \"a_digits\": " << r.a_digits << ", \"b_digits\": " << r.b_digits
+       << ", \"iterations\": " << r.iterations << ", \"ns_per_op\": " << std::fixed << std::setprecision(1)
+       << r.ns_per_op << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+  }
+  os << "]\n";
+}
+
+// Reads ns_per_op by (op, shape, digits) from a CSV written by WriteCsv.
+std::map<std::string, double> ReadBaseline(std::istream& is) {
+  std::map<std::string, double> baseline;
+  std::string line;
+  std::getline(is, line);
+  while (std::getline(is, line)) {
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    for (std::string field; std::getline(iss, field, ',');) {
+      fields.push_back(field);
+    }
+    if (fields.size() == 7) {
+      baseline[Key(fields[0], fields[1], std::stoull(fields[2]))] = std::stod(fields[6]);
+    }
+  }
+  return baseline;
+}
+
+// Prints the ratio to the baseline of every case it covers and returns the number of regressions.
+size_t CompareWithBaseline(const std::vector<Result>& results, const std::map<std::string, double>& baseline,
+                           double tolerance) {
+  size_t regressions = 0;
+  for (const auto& r : results) {
+    auto it = baseline.find(Key(r.op, r.shape, r.digits));
+    if (it == baseline.end() || it->second <= 0) {
+      continue;
+    }
+    double ratio = r.ns_per_op / it->second;
+    bool regressed = ratio > 1 + tolerance;
+    regressions += regressed;
+    std::cerr << (regressed ? "REGRESSION " : "           ") << Key(r.op, r.shape, r.digits) << ": " << std::fixed
+              << std::setprecision(2) << ratio << "x\n";
+  }
+  return regressions;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 == argc) {
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--max-digits") {
+      options.max_digits = std::stoull(value);
+    } else if (arg == "--min-time-ms") {
+      options.min_time_ms = std::stod(value);
+    } else if (arg == "--csv") {
+      options.csv = value;
+    } else if (arg == "--json") {
+      options.json = value;
+    } else if (arg == "--baseline") {
+      options.baseline = value;
+    } else if (arg == "--tolerance") {
+      options.tolerance = std::stod(value);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    std::cerr << "usage: " << argv[0]
+              << " [--max-digits N] [--min-time-ms T] [--csv FILE] [--json FILE] [--baseline FILE]"
+                 " [--tolerance F]\n";
+    return 2;
+  }
+  // Balanced division takes 2n-digit dividends and the pi series builds products of about 3n digits;
+  // none of them may hit the size limit.
+  BigInteger::SetMaxDigitCount(8 * options.max_digits + 100);
+
+  std::vector<Result> results;
+  Sweep(options, results);
+
+  WriteCsv(std::cout, results);
+  if (!options.csv.empty()) {
+    std::ofstream out(options.csv);
+    WriteCsv(out, results);
+  }
+  if (!options.json.empty()) {
+    std::ofstream out(options.json);
+    WriteJson(out, results);
+  }
+  if (!options.baseline.empty()) {
+    std::ifstream in(options.baseline);
+    if (!in) {
+      std::cerr << "cannot read baseline " << options.baseline << '\n';
+      return 2;
+    }
+    if (CompareWithBaseline(results, ReadBaseline(in), options.tolerance) > 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
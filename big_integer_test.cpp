@@ -1,10 +1,35 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+#include <atomic>
+#include <cstdlib>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <new>
 
 #include "big_integer.h"
 #include "big_integer.h"  // check include guards
+#include "vector.h"
+
+// Every heap allocation of the test binary, for the checks that small values stay inline.
+std::atomic<size_t> heap_allocations{0};
+
+void* operator new(size_t size) {
+  heap_allocations.fetch_add(1);
+  if (void* pointer = std::malloc(size == 0 ? 1 : size)) {
+    return pointer;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+  std::free(pointer);
+}
 
 TEST_CASE("Constructors") {
   std::ostringstream oss;
@@ -61,6 +86,27 @@ TEST_CASE("CompoundAdd") {
   x += BigInteger(11);
   REQUIRE(x == BigInteger(0));
   REQUIRE_FALSE(x.IsNegative());
+  x = BigInteger(-5);
+  x += BigInteger(0);
+  REQUIRE(x == BigInteger(-5));
+  x -= BigInteger(0);
+  REQUIRE(x == BigInteger(-5));
+
+  // The carry out of the top limb grows the value by one limb.
+  const BigInteger below_2_128("340282366920938463463374607431768211455");
+  const BigInteger two_128("340282366920938463463374607431768211456");
+  x = below_2_128;
+  x += BigInteger(1);
+  REQUIRE(x == two_128);
+  x = below_2_128;
+  x += x;
+  REQUIRE(x == two_128 + below_2_128 - BigInteger(1));
+  x = -below_2_128;
+  x -= BigInteger(1);
+  REQUIRE(x == -two_128);
+  x = below_2_128;
+  REQUIRE(++x == two_128);
+  REQUIRE(--x == below_2_128);
 }
 
 TEST_CASE("Sum") {
@@ -114,8 +160,249 @@ TEST_CASE("Multiplication") {
   REQUIRE(x * -y == -res);
   REQUIRE(-x * y == -res);
   REQUIRE(-x * -y == res);
-  REQUIRE_THROWS_AS((void)(BigInteger(std::string(50'000, '1').c_str()) * BigInteger(large.c_str())),
-                    BigIntegerOverflow);  // NOLINT
+  if (kBigIntegerChecked) {
+    REQUIRE_THROWS_AS((void)(BigInteger(std::string(50'000, '1').c_str()) * BigInteger(large.c_str())),
+                      BigIntegerOverflow);  // NOLINT
+  }
+}
+
+std::string RandomNumber(size_t digits, uint32_t seed) {
+  std::string result;
+  for (size_t i = 0; i < digits; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    result.push_back(static_cast<char>('0' + (seed >> 16) % 10));
+  }
+  result[0] = static_cast<char>('1' + seed % 9);
+  return result;
+}
+
+TEST_CASE("DecimalConversion") {
+  const std::string limb_boundaries[] = {"18446744073709551615",
+                                         "18446744073709551616",
+                                         "-340282366920938463463374607431768211456",
+                                         "10000000000000000000",
+                                         "9999999999999999999",
+                                         "-9223372036854775808",
+                                         "1" + std::string(56, '0') + "1"};
+  for (const std::string& text : limb_boundaries) {
+    std::ostringstream oss;
+    oss << BigInteger(text);
+    REQUIRE(oss.str() == text);
+  }
+
+  const BigInteger max_limb("18446744073709551615");
+  REQUIRE(max_limb + BigInteger(1) == BigInteger("18446744073709551616"));
+  REQUIRE(BigInteger("18446744073709551616") - BigInteger(1) == max_limb);
+  REQUIRE(max_limb * max_limb == BigInteger("340282366920938463426481119284349108225"));
+  REQUIRE(BigInteger("-0") == BigInteger(0));
+  REQUIRE_FALSE(BigInteger("-000").IsNegative());
+  REQUIRE(BigInteger("+00012") == BigInteger(12));
+  if (kBigIntegerChecked) {
+    REQUIRE_THROWS_AS(BigInteger("12a4"), BigIntegerOverflow);  // NOLINT
+    REQUIRE_THROWS_AS(BigInteger("1234567890123456789/"), BigIntegerOverflow);  // NOLINT
+    REQUIRE_THROWS_AS(BigInteger(std::string(700, '7') + "\xb7"), BigIntegerOverflow);  // NOLINT
+  }
+
+  // Long enough for the divide-and-conquer conversion, with runs of zeros across the split points.
+  for (size_t digits : {700, 5000, 40000}) {
+    std::string text = RandomNumber(digits, static_cast<uint32_t>(digits));
+    std::fill(text.begin() + digits / 3, text.begin() + digits / 2, '0');
+    std::ostringstream oss;
+    oss << -BigInteger(text);
+    REQUIRE(oss.str() == "-" + text);
+    REQUIRE(BigInteger(text).DigitCount() == digits);
+  }
+  REQUIRE(BigInteger("1" + std::string(1000, '0')).DigitCount() == 1001);
+  REQUIRE((BigInteger("1" + std::string(1000, '0')) - BigInteger(1)).DigitCount() == 1000);
+}
+
+TEST_CASE("KaratsubaMatchesSchoolbook") {
+  using Algorithm = BigInteger::MultiplyAlgorithm;
+  const size_t default_threshold = BigInteger::MultiplyThreshold(Algorithm::kKaratsuba);
+  const std::pair<size_t, size_t> shapes[] = {{1, 1},     {7, 300},    {160, 161},  {400, 400},
+                                              {999, 1000}, {3000, 250}, {5000, 5000}, {12000, 3}};
+
+  for (size_t threshold : {size_t{2}, size_t{5}, default_threshold}) {
+    BigInteger::SetMultiplyThreshold(Algorithm::kKaratsuba, threshold);
+    uint32_t seed = 17;
+    for (const auto& [lhs_digits, rhs_digits] : shapes) {
+      const BigInteger a(RandomNumber(lhs_digits, ++seed));
+      const BigInteger b = -BigInteger(RandomNumber(rhs_digits, ++seed));
+      const BigInteger expected = BigInteger::Multiply(a, b, Algorithm::kSchoolbook);
+      REQUIRE(BigInteger::Multiply(a, b, Algorithm::kKaratsuba) == expected);
+      REQUIRE(a * b == expected);
+      REQUIRE(b * a == expected);
+    }
+  }
+  BigInteger::SetMultiplyThreshold(Algorithm::kKaratsuba, default_threshold);
+
+  const BigInteger nines(std::string(8000, '9'));
+  const BigInteger square = BigInteger::Multiply(nines, nines, Algorithm::kKaratsuba);
+  REQUIRE(square == BigInteger(std::string(7999, '9') + "8" + std::string(7999, '0') + "1"));
+}
+
+TEST_CASE("ToomCookMatchesSchoolbook") {
+  using Algorithm = BigInteger::MultiplyAlgorithm;
+  const Algorithm tiers[] = {Algorithm::kKaratsuba, Algorithm::kToom3, Algorithm::kToom4};
+  size_t defaults[3];
+  for (size_t i = 0; i < 3; ++i) {
+    defaults[i] = BigInteger::MultiplyThreshold(tiers[i]);
+  }
+
+  const std::pair<size_t, size_t> shapes[] = {{30, 30},     {41, 35},     {700, 400},  {1203, 1187},
+                                              {2000, 1001}, {4000, 3999}, {6001, 5000}, {9000, 2000}};
+  const size_t low_thresholds[][3] = {{4, 8, 16}, {2, 6, 9}, {8, 1000, 10}, {4, 12, 1000}};
+
+  for (const auto& thresholds : low_thresholds) {
+    for (size_t i = 0; i < 3; ++i) {
+      BigInteger::SetMultiplyThreshold(tiers[i], thresholds[i]);
+    }
+    uint32_t seed = 101;
+    for (const auto& [lhs_digits, rhs_digits] : shapes) {
+      const BigInteger a = -BigInteger(RandomNumber(lhs_digits, ++seed));
+      const BigInteger b(RandomNumber(rhs_digits, ++seed));
+      const BigInteger expected = BigInteger::Multiply(a, b, Algorithm::kSchoolbook);
+      REQUIRE(BigInteger::Multiply(a, b, Algorithm::kToom3) == expected);
+      REQUIRE(BigInteger::Multiply(b, a, Algorithm::kToom4) == expected);
+      REQUIRE(a * b == expected);
+    }
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    BigInteger::SetMultiplyThreshold(tiers[i], defaults[i]);
+  }
+
+  const BigInteger nines(std::string(12000, '9'));
+  const BigInteger expected = BigInteger(std::string(11999, '9') + "8" + std::string(11999, '0') + "1");
+  REQUIRE(BigInteger::Multiply(nines, nines, Algorithm::kToom3) == expected);
+  REQUIRE(BigInteger::Multiply(nines, nines, Algorithm::kToom4) == expected);
+  REQUIRE(BigInteger::Multiply(nines, BigInteger(0), Algorithm::kToom4) == BigInteger(0));
+}
+
+TEST_CASE("NttMatchesSchoolbook") {
+  using Algorithm = BigInteger::MultiplyAlgorithm;
+  const std::pair<size_t, size_t> shapes[] = {{1, 1}, {5, 3}, {900, 1100}, {4000, 16}, {7000, 7000}, {15000, 14000}};
+
+  uint32_t seed = 7;
+  for (const auto& [lhs_digits, rhs_digits] : shapes) {
+    const BigInteger a(RandomNumber(lhs_digits, ++seed));
+    const BigInteger b = -BigInteger(RandomNumber(rhs_digits, ++seed));
+    const BigInteger expected = BigInteger::Multiply(a, b, Algorithm::kSchoolbook);
+    REQUIRE(BigInteger::Multiply(a, b, Algorithm::kNtt) == expected);
+    REQUIRE(BigInteger::Multiply(b, a, Algorithm::kNtt) == expected);
+  }
+
+  const size_t default_threshold = BigInteger::MultiplyThreshold(Algorithm::kNtt);
+  BigInteger::SetMultiplyThreshold(Algorithm::kNtt, 8);
+  const BigInteger a(RandomNumber(20000, 1));
+  const BigInteger b(RandomNumber(9000, 2));
+  REQUIRE(a * b == BigInteger::Multiply(a, b, Algorithm::kToom4));
+  BigInteger::SetMultiplyThreshold(Algorithm::kNtt, default_threshold);
+}
+
+TEST_CASE("ParallelMultiplyMatchesSequential") {
+  using Algorithm = BigInteger::MultiplyAlgorithm;
+  const size_t default_threshold = BigInteger::ParallelThreshold();
+  const std::pair<size_t, size_t> shapes[] = {{5000, 5000}, {14000, 9000}, {15000, 15000}};
+
+  uint32_t seed = 29;
+  for (const auto& [lhs_digits, rhs_digits] : shapes) {
+    const BigInteger a(RandomNumber(lhs_digits, ++seed));
+    const BigInteger b = -BigInteger(RandomNumber(rhs_digits, ++seed));
+    for (Algorithm algorithm : {Algorithm::kToom3, Algorithm::kToom4, Algorithm::kNtt}) {
+      BigInteger::SetMultiplyThreads(1);
+      const BigInteger expected = BigInteger::Multiply(a, b, algorithm);
+      const BigInteger expected_square = BigInteger::Square(a, algorithm);
+      for (size_t threads : {2, 3, 8}) {
+        BigInteger::SetMultiplyThreads(threads);
+        BigInteger::SetParallelThreshold(8);
+        REQUIRE(BigInteger::Multiply(a, b, algorithm) == expected);
+        REQUIRE(BigInteger::Square(a, algorithm) == expected_square);
+        BigInteger::SetParallelThreshold(default_threshold);
+      }
+    }
+  }
+
+  // The settings may change while other threads multiply.
+  const BigInteger a(RandomNumber(12000, 41));
+  const BigInteger b(RandomNumber(12000, 42));
+  const BigInteger expected = BigInteger::Multiply(a, b, Algorithm::kToom4);
+  BigInteger::SetMultiplyThreads(4);
+  BigInteger::SetParallelThreshold(8);
+  auto worker = std::async(std::launch::async, [&] { return BigInteger::Multiply(a, b, Algorithm::kToom4); });
+  for (size_t threads : {1, 3, 2, 4}) {
+    BigInteger::SetMultiplyThreads(threads);
+    BigInteger::SetParallelThreshold(8 * threads);
+  }
+  REQUIRE(worker.get() == expected);
+  BigInteger::SetParallelThreshold(default_threshold);
+
+  BigInteger::SetMultiplyThreads(1);
+  REQUIRE(BigInteger::MultiplyThreads() == 1);
+  BigInteger::SetMultiplyThreads(0);
+  REQUIRE(BigInteger::MultiplyThreads() >= 1);
+  BigInteger::SetMultiplyThreads(1);
+}
+
+TEST_CASE("Square") {
+  using Algorithm = BigInteger::MultiplyAlgorithm;
+  const Algorithm tiers[] = {Algorithm::kKaratsuba, Algorithm::kToom3, Algorithm::kToom4, Algorithm::kNtt};
+  size_t defaults[4];
+  for (size_t i = 0; i < 4; ++i) {
+    defaults[i] = BigInteger::MultiplyThreshold(tiers[i]);
+  }
+
+  const size_t low_thresholds[][4] = {{2, 6, 8, 1000}, {4, 1000, 1000, 16}};
+  for (const auto& thresholds : low_thresholds) {
+    for (size_t i = 0; i < 4; ++i) {
+      BigInteger::SetMultiplyThreshold(tiers[i], thresholds[i]);
+    }
+    uint32_t seed = 5;
+    for (size_t digits : {1, 20, 39, 77, 400, 1500, 6000}) {
+      const BigInteger x = -BigInteger(RandomNumber(digits, ++seed));
+      const BigInteger copy = x;
+      const BigInteger expected = BigInteger::Multiply(x, copy, Algorithm::kSchoolbook);
+      for (Algorithm algorithm : {Algorithm::kAuto, Algorithm::kSchoolbook, Algorithm::kKaratsuba, Algorithm::kToom3,
+                                  Algorithm::kToom4, Algorithm::kNtt}) {
+        REQUIRE(BigInteger::Square(x, algorithm) == expected);
+      }
+      REQUIRE(x * x == expected);
+      BigInteger y = x;
+      y *= y;
+      REQUIRE(y == expected);
+    }
+  }
+  for (size_t i = 0; i < 4; ++i) {
+    BigInteger::SetMultiplyThreshold(tiers[i], defaults[i]);
+  }
+
+  const BigInteger max_limbs("340282366920938463463374607431768211455");
+  REQUIRE(BigInteger::Square(max_limbs) == max_limbs * BigInteger(max_limbs));
+  REQUIRE(BigInteger::Square(BigInteger(0)) == BigInteger(0));
+  REQUIRE_FALSE(BigInteger::Square(BigInteger(-3)).IsNegative());
+}
+
+TEST_CASE("MaxDigitCount") {
+  const size_t default_limit = BigInteger::MaxDigitCount();
+  const BigInteger ones(std::string(50'000, '1'));
+  const BigInteger nines(std::string(24, '9'));
+  if (kBigIntegerChecked) {
+    REQUIRE_THROWS_AS((void)(ones * nines), BigIntegerOverflow);  // NOLINT
+  } else {
+    REQUIRE((ones * nines).DigitCount() == 50'024);
+  }
+
+  BigInteger::SetMaxDigitCount(std::numeric_limits<size_t>::max());
+  REQUIRE((ones * nines).DigitCount() == 50'024);
+
+  const size_t digits = 500'000;
+  const BigInteger huge(std::string(digits, '9'));
+  REQUIRE(huge * huge == BigInteger(std::string(digits - 1, '9') + "8" + std::string(digits - 1, '0') + "1"));
+
+  BigInteger::SetMaxDigitCount(1000);
+  if (kBigIntegerChecked) {
+    REQUIRE_THROWS_AS((void)(huge * huge), BigIntegerOverflow);  // NOLINT
+  }
+  BigInteger::SetMaxDigitCount(default_limit);
 }
 
 TEST_CASE("Increment") {
@@ -142,6 +429,176 @@ TEST_CASE("Decrement") {
   REQUIRE_FALSE(x.IsNegative());
 }
 
+TEST_CASE("NativeOperands") {
+  const int64_t min = std::numeric_limits<int64_t>::min();
+  const int64_t max = std::numeric_limits<int64_t>::max();
+
+  BigInteger x(9999);
+  x += 1;
+  REQUIRE(x == BigInteger(10000));
+  x -= 10001;
+  REQUIRE(x == BigInteger(-1));
+  x += 1;
+  REQUIRE(x == 0);
+  REQUIRE_FALSE(x.IsNegative());
+  x -= min;
+  REQUIRE(x == BigInteger("9223372036854775808"));
+  x += min;
+  REQUIRE(x == 0);
+  x += min;
+  REQUIRE(x == min);
+  REQUIRE(x == BigInteger(min));
+
+  x = BigInteger("-123456789012345678901234567890");
+  REQUIRE(x * 7 == x * BigInteger(7));
+  REQUIRE(7 * x == x * BigInteger(7));
+  REQUIRE(x * max == x * BigInteger(max));
+  REQUIRE(x * min == x * BigInteger(min));
+  REQUIRE(x * 0 == 0);
+  REQUIRE_FALSE((x * 0).IsNegative());
+  REQUIRE(x + 1 == x + BigInteger(1));
+  REQUIRE(1 + x == x + BigInteger(1));
+  REQUIRE(x - max == x - BigInteger(max));
+
+  for (int64_t divisor : {int64_t{1}, int64_t{-3}, int64_t{10}, int64_t{9999}, int64_t{10007}, max, min,
+                          int64_t{-4294967311}}) {
+    REQUIRE(x / divisor == x / BigInteger(divisor));
+    REQUIRE(x % divisor == x % BigInteger(divisor));
+    BigInteger quotient = x;
+    int64_t remainder = quotient.DivideWithRemainder(divisor);
+    REQUIRE(quotient == x / BigInteger(divisor));
+    REQUIRE(BigInteger(remainder) == x % BigInteger(divisor));
+  }
+  REQUIRE_THROWS_AS(x /= 0, BigIntegerDivisionByZero);  // NOLINT
+  REQUIRE_THROWS_AS(x %= 0, BigIntegerDivisionByZero);  // NOLINT
+
+  REQUIRE(BigInteger(5) < 6);
+  REQUIRE(6 > BigInteger(5));
+  REQUIRE(BigInteger(-5) < 0);
+  REQUIRE(0 <= BigInteger(0));
+  REQUIRE(BigInteger(min) <= min);
+  REQUIRE(BigInteger(min) - 1 < min);
+  REQUIRE(BigInteger(max) + 1 > max);
+  REQUIRE(BigInteger(max) != -1);
+  REQUIRE(x < min);
+
+  // Unsigned operands above INT64_MAX keep their value instead of wrapping to negative ones.
+  const uint64_t umax = std::numeric_limits<uint64_t>::max();
+  const BigInteger big_umax("18446744073709551615");
+  BigInteger y(0);
+  y += umax;
+  REQUIRE(y == big_umax);
+  y -= umax;
+  REQUIRE(y == 0);
+  y -= umax;
+  REQUIRE(y == -big_umax);
+  y *= umax;
+  REQUIRE(y == -big_umax * big_umax);
+  y /= umax;
+  REQUIRE(y == -big_umax);
+  y -= 5;
+  y %= umax;
+  REQUIRE(y == -5);
+  REQUIRE(x + umax == x + big_umax);
+  REQUIRE(umax + x == x + big_umax);
+  REQUIRE(x - umax == x - big_umax);
+  REQUIRE(x * umax == x * big_umax);
+  REQUIRE(umax * x == x * big_umax);
+  REQUIRE(x / umax == x / big_umax);
+  REQUIRE(x % umax == x % big_umax);
+  REQUIRE(x * size_t{3} == x * 3);
+  REQUIRE(x * 3u == x * 3);
+  REQUIRE_THROWS_AS(x /= uint64_t{0}, BigIntegerDivisionByZero);  // NOLINT
+  REQUIRE_THROWS_AS(x %= uint64_t{0}, BigIntegerDivisionByZero);  // NOLINT
+
+  REQUIRE(BigInteger(5) < umax);
+  REQUIRE(umax > BigInteger(5));
+  REQUIRE(BigInteger(-1) < umax);
+  REQUIRE(big_umax == umax);
+  REQUIRE(umax == big_umax);
+  REQUIRE(big_umax + 1 > umax);
+  REQUIRE(big_umax - 1 != umax);
+  REQUIRE(umax >= big_umax);
+  REQUIRE(umax <= big_umax);
+  REQUIRE(BigInteger(max) < uint64_t{1} << 63);
+  REQUIRE(BigInteger(0) == 0u);
+
+  BigInteger counter;
+  for (int i = 0; i < 20000; ++i) {
+    ++counter;
+  }
+  for (int i = 0; i < 30000; ++i) {
+    counter--;
+  }
+  REQUIRE(counter == -10000);
+}
+
+TEST_CASE("InlineAndHeapStorage") {
+  const int64_t max = std::numeric_limits<int64_t>::max();
+  Vector<BigInteger> values;
+  for (int64_t i = 0; i < 1000; ++i) {
+    values.EmplaceBack(i * 1'000'000'007 - 500);
+  }
+
+  // One- and two-limb arithmetic stays in the inline storage; the two-limb values stay near 2^110.
+  const BigInteger two_100 = BigInteger(1) << 100;
+  BigInteger sum;
+  BigInteger product;
+  BigInteger wide = two_100;
+  BigInteger difference;
+  const size_t allocations = heap_allocations.load();
+  for (const BigInteger& value : values) {
+    BigInteger copy = value;
+    sum += copy;
+    sum -= 1;
+    sum *= 3;
+    sum %= max;
+    ++sum;
+    product = copy * BigInteger(-7) / BigInteger(3) - sum;
+    product %= BigInteger(max);
+
+    wide += two_100;
+    wide += copy;
+    ++wide;
+    difference = wide - two_100;
+    difference -= copy;
+    wide += max;
+    wide = wide + wide - wide;
+  }
+  const size_t loop_allocations = heap_allocations.load() - allocations;
+  REQUIRE(loop_allocations == 0);
+  REQUIRE(sum == BigInteger("4357867509907553354"));
+  BigInteger expected = two_100 * BigInteger(1001) + BigInteger(max) * BigInteger(1000) + BigInteger(1000);
+  for (const BigInteger& value : values) {
+    expected += value;
+  }
+  REQUIRE(wide == expected);
+  REQUIRE(difference == wide - BigInteger(max) - two_100 - values.Back());
+
+  Vector<BigInteger> moved = std::move(values);
+  moved.PushBack(BigInteger(max) * BigInteger(max));
+  REQUIRE(moved[999] == BigInteger(999'000'006'493));
+  REQUIRE(moved.Back() == BigInteger("85070591730234615847396907784232501249"));
+
+  const BigInteger cube = BigInteger(max) * BigInteger(max) * BigInteger(max);
+  BigInteger large = cube;
+  BigInteger small = std::move(large);
+  large = small;
+  REQUIRE(large == cube);
+  small = 7;
+  large = std::move(small);
+  REQUIRE(large == 7);
+  small = cube;
+  small /= cube;
+  REQUIRE(small == 1);
+  small *= cube;
+  REQUIRE(small == cube);
+
+  SmallBuffer<uint64_t, 2> buffer;
+  REQUIRE_THROWS_AS(buffer.Reserve(size_t{1} << 33), std::length_error);  // NOLINT
+  REQUIRE(buffer.IsInline());
+}
+
 template <class T>
 void CheckComparisonEqual(const T& lhs, const T& rhs) {
   REQUIRE(lhs == rhs);
@@ -249,4 +706,698 @@ TEST_CASE("Residual") {
   REQUIRE(-y % -x == BigInteger(-90));
 }
 
+TEST_CASE("LongDivision") {
+  const std::pair<size_t, size_t> shapes[] = {{1, 1},    {9, 5},      {40, 8},     {100, 99},  {300, 150},
+                                              {801, 17}, {1000, 998}, {2500, 700}, {4000, 3999}};
+
+  uint32_t seed = 3;
+  for (const auto& [dividend_digits, divisor_digits] : shapes) {
+    for (int sign = 0; sign < 4; ++sign) {
+      BigInteger a(RandomNumber(dividend_digits, ++seed));
+      BigInteger b(RandomNumber(divisor_digits, ++seed));
+      if (sign & 1) {
+        a = -a;
+      }
+      if (sign & 2) {
+        b = -b;
+      }
+      const BigInteger q = a / b;
+      const BigInteger r = a % b;
+      REQUIRE(q * b + r == a);
+      REQUIRE(r.Absolute() < b.Absolute());
+      REQUIRE((!r || r.IsNegative() == a.IsNegative()));
+    }
+  }
+
+  // Quotient limbs whose first estimate overshoots and needs the add-back step.
+  const BigInteger base_power("1" + std::string(40, '0'));
+  const BigInteger divisor = base_power / BigInteger(10000) + BigInteger(1);
+  const BigInteger dividend = divisor * BigInteger("99999999999999999999999999") - BigInteger(1);
+  REQUIRE(dividend / divisor == BigInteger("99999999999999999999999998"));
+  REQUIRE(dividend % divisor == divisor - BigInteger(1));
+
+  const BigInteger nines(std::string(400, '9'));
+  REQUIRE(nines / BigInteger(std::string(200, '9')) == BigInteger("1" + std::string(199, '0') + "1"));
+  REQUIRE(nines % BigInteger(std::string(200, '9')) == BigInteger(0));
+  REQUIRE(BigInteger("123456789012345678901234567890") / BigInteger(7) == BigInteger("17636684144620811271604938270"));
+}
+
+TEST_CASE("BurnikelZieglerMatchesSchoolbook") {
+  const size_t default_threshold = BigInteger::DivideThreshold();
+  const std::pair<size_t, size_t> shapes[] = {{60, 30},     {200, 37},    {513, 256},   {1000, 999},
+                                              {4000, 1000}, {8001, 4000}, {12000, 300}, {20000, 9000}};
+
+  uint32_t seed = 41;
+  for (const auto& [dividend_digits, divisor_digits] : shapes) {
+    const BigInteger a(RandomNumber(dividend_digits, ++seed));
+    const BigInteger b = -BigInteger(RandomNumber(divisor_digits, ++seed));
+
+    BigInteger::SetDivideThreshold(std::numeric_limits<size_t>::max());
+    const BigInteger expected_quotient = a / b;
+    const BigInteger expected_remainder = a % b;
+
+    for (size_t threshold : {size_t{2}, size_t{3}, size_t{8}, default_threshold}) {
+      BigInteger::SetDivideThreshold(threshold);
+      REQUIRE(a / b == expected_quotient);
+      REQUIRE(a % b == expected_remainder);
+      REQUIRE(-a / b == -expected_quotient);
+    }
+  }
+  BigInteger::SetDivideThreshold(default_threshold);
+
+  const BigInteger nines(std::string(40000, '9'));
+  const BigInteger divisor(std::string(20000, '9'));
+  REQUIRE(nines / divisor == BigInteger("1" + std::string(19999, '0') + "1"));
+  REQUIRE(nines % divisor == BigInteger(0));
+  REQUIRE((nines - BigInteger(1)) % divisor == divisor - BigInteger(1));
+}
+
+TEST_CASE("DivMod") {
+  const BigInteger x("-1234567890123456789012345678901234567890");
+  const BigInteger y("98765432109876543210");
+
+  auto [quotient, remainder] = BigInteger::DivMod(x, y);
+  REQUIRE(quotient == x / y);
+  REQUIRE(remainder == x % y);
+  REQUIRE(quotient * y + remainder == x);
+
+  BigInteger q;
+  BigInteger r;
+  BigInteger::DivMod(y, BigInteger(-7), q, r);
+  REQUIRE(q == BigInteger("-14109347444268077601"));
+  REQUIRE(r == BigInteger(3));
+
+  BigInteger value = x;
+  BigInteger::DivMod(value, y, value, r);
+  REQUIRE(value == quotient);
+  REQUIRE(r == remainder);
+
+  value = x;
+  BigInteger::DivMod(value, value, q, value);
+  REQUIRE(q == BigInteger(1));
+  REQUIRE(value == BigInteger(0));
+
+  value = BigInteger(193);
+  REQUIRE(value.DivideWithRemainder(BigInteger(10), r) == BigInteger(19));
+  REQUIRE(r == BigInteger(3));
+  REQUIRE_THROWS_AS(value.DivideWithRemainder(BigInteger(0), r), BigIntegerDivisionByZero);  // NOLINT
+  REQUIRE_THROWS_AS(BigInteger::DivMod(value, BigInteger(0)), BigIntegerDivisionByZero);     // NOLINT
+}
+
+TEST_CASE("Pow") {
+  REQUIRE(BigInteger::Pow(BigInteger(2), 100) == BigInteger("1267650600228229401496703205376"));
+  REQUIRE(BigInteger::Pow(BigInteger(-3), 5) == BigInteger(-243));
+  REQUIRE(BigInteger::Pow(BigInteger(7), 77) ==
+          BigInteger("118181386580595879976868414312001964434038548836769923458287039207"));
+  REQUIRE(BigInteger::Pow(BigInteger(10), 500) == BigInteger("1" + std::string(500, '0')));
+  REQUIRE(BigInteger::Pow(BigInteger(0), 0) == BigInteger(1));
+  REQUIRE(BigInteger::Pow(BigInteger(0), 9) == BigInteger(0));
+  REQUIRE(BigInteger::Pow(BigInteger(-1), std::numeric_limits<uint64_t>::max()) == BigInteger(-1));
+  if (kBigIntegerChecked) {
+    REQUIRE_THROWS_AS(BigInteger::Pow(BigInteger(2), 1'000'000), BigIntegerOverflow);  // NOLINT
+  }
+}
+
+TEST_CASE("ProductTrees") {
+  BigInteger factorial(1);
+  for (uint64_t n = 0; n <= 3000; ++n) {
+    if (n > 0) {
+      factorial *= BigInteger(static_cast<int64_t>(n));
+    }
+    if (n <= 300 || n % 250 == 0) {
+      REQUIRE(BigInteger::Factorial(n) == factorial);
+    }
+  }
+  REQUIRE(BigInteger::Factorial(25) == BigInteger("15511210043330985984000000"));
+
+  std::vector<BigInteger> row = {BigInteger(1)};
+  for (uint64_t n = 1; n <= 100; ++n) {
+    std::vector<BigInteger> next(n + 1, BigInteger(1));
+    for (uint64_t k = 1; k < n; ++k) {
+      next[k] = row[k - 1] + row[k];
+    }
+    row = std::move(next);
+    for (uint64_t k = 0; k <= n + 1; ++k) {
+      REQUIRE(BigInteger::Binomial(n, k) == (k <= n ? row[k] : BigInteger(0)));
+    }
+  }
+  REQUIRE(BigInteger::Binomial(4000, 1300) ==
+          BigInteger::Factorial(4000) / (BigInteger::Factorial(1300) * BigInteger::Factorial(2700)));
+  const uint64_t big = (uint64_t{1} << 62) + 12345;
+  BigInteger n(static_cast<int64_t>(big));
+  REQUIRE(BigInteger::Binomial(big, 3) == n * (n - 1) * (n - 2) / 6);
+  REQUIRE(BigInteger::Binomial(big, big - 2) == n * (n - 1) / 2);
+
+  REQUIRE(BigInteger::ProductRange(7, 6) == BigInteger(1));
+  REQUIRE(BigInteger::ProductRange(0, 5) == BigInteger(0));
+  REQUIRE(BigInteger::ProductRange(1, 2000) == BigInteger::Factorial(2000));
+  REQUIRE(BigInteger::ProductRange(1001, 2500) == BigInteger::Factorial(2500) / BigInteger::Factorial(1000));
+  const uint64_t max = std::numeric_limits<uint64_t>::max();
+  BigInteger expected(1);
+  for (uint64_t i = max - 40; i != 0; ++i) {
+    expected *= BigInteger(std::to_string(i).c_str());
+  }
+  REQUIRE(BigInteger::ProductRange(max - 40, max) == expected);
+
+  if (kBigIntegerChecked) {
+    REQUIRE_THROWS_AS(BigInteger::Factorial(1'000'000), BigIntegerOverflow);                // NOLINT
+    REQUIRE_THROWS_AS(BigInteger::Factorial(10'000), BigIntegerOverflow);                   // NOLINT
+    REQUIRE_THROWS_AS(BigInteger::Binomial(uint64_t{1} << 40, uint64_t{1} << 39), BigIntegerOverflow);  // NOLINT
+    REQUIRE_THROWS_AS(BigInteger::ProductRange(1, uint64_t{1} << 62), BigIntegerOverflow);  // NOLINT
+  }
+}
+
+// floor(pi * 10^digits) up to a few units in the last place, by the Chudnovsky series. The pi case of
+// big_integer_benchmark times the same computation.
+BigInteger ChudnovskyPi(size_t digits) {
+  BinarySplitting series(
+      [](uint64_t n) {
+        int64_t k = static_cast<int64_t>(n);
+        return n == 0 ? BigInteger(1) : BigInteger(-(6 * k - 5)) * (2 * k - 1) * (6 * k - 1);
+      },
+      [](uint64_t n) {
+        int64_t k = static_cast<int64_t>(n);
+        return n == 0 ? BigInteger(1) : BigInteger(k * k * k) * 10939058860032000;
+      },
+      [](uint64_t n) { return BigInteger(13591409 + 545140134 * static_cast<int64_t>(n)); });
+  // Each term adds a little over 14 digits.
+  SeriesSums sums = series.Evaluate(0, digits / 14 + 2);
+  BigInteger root = BigInteger::Sqrt(BigInteger::Pow(BigInteger(10), 2 * digits) * 10005);
+  return root * 426880 * sums.q / sums.t;
+}
+
+// floor(10^digits * arctan(1 / x)) up to a few units in the last place.
+BigInteger ArctanInverse(int64_t x, size_t digits) {
+  BinarySplitting series([](uint64_t n) { return BigInteger(n == 0 ? 1 : 1 - 2 * static_cast<int64_t>(n)); },
+                         [x](uint64_t n) { return BigInteger(n == 0 ? x : (2 * static_cast<int64_t>(n) + 1) * x * x); },
+                         [](uint64_t) { return BigInteger(1); });
+  SeriesSums sums = series.Evaluate(0, static_cast<uint64_t>(digits / std::log10(x * x)) + 2);
+  return BigInteger::Pow(BigInteger(10), digits) * sums.t / sums.q;
+}
+
+TEST_CASE("BinarySplitting") {
+  const size_t digits = 2000;
+  BigInteger pi = ChudnovskyPi(digits);
+  REQUIRE(pi / BigInteger::Pow(BigInteger(10), digits - 50) ==
+          BigInteger("314159265358979323846264338327950288419716939937510"));
+  BigInteger machin = ArctanInverse(5, digits) * 16 - ArctanInverse(239, digits) * 4;
+  REQUIRE((pi - machin).Absolute() < BigInteger(100));
+
+  // e = sum 1 / n!.
+  BinarySplitting exp_series([](uint64_t) { return BigInteger(1); },
+                             [](uint64_t n) { return BigInteger(n == 0 ? 1 : static_cast<int64_t>(n)); },
+                             [](uint64_t) { return BigInteger(1); });
+  SeriesSums e = exp_series.Evaluate(0, 100);
+  REQUIRE(BigInteger::Pow(BigInteger(10), 40) * e.t / e.q == BigInteger("27182818284590452353602874713526624977572"));
+
+  SeriesSums empty = exp_series.Evaluate(5, 5);
+  REQUIRE(empty.p == BigInteger(1));
+  REQUIRE(empty.q == BigInteger(1));
+  REQUIRE(empty.t == BigInteger(0));
+
+  BigInteger::SetMultiplyThreads(4);
+  REQUIRE(ChudnovskyPi(digits) == pi);
+  BigInteger::SetMultiplyThreads(1);
+}
+
+BigInteger NaivePowMod(BigInteger base, BigInteger exponent, const BigInteger& modulus) {
+  BigInteger result(1);
+  base %= modulus;
+  if (base.IsNegative()) {
+    base += modulus;
+  }
+  while (exponent) {
+    if (exponent.DivideWithRemainder(2) != 0) {
+      result = result * base % modulus;
+    }
+    base = base * base % modulus;
+  }
+  return result % modulus;
+}
+
+TEST_CASE("PowMod") {
+  const BigInteger mersenne = BigInteger::Pow(BigInteger(2), 127) - BigInteger(1);
+  REQUIRE(BigInteger::PowMod(BigInteger(3), BigInteger("1" + std::string(39, '0') + "7"), mersenne) ==
+          BigInteger("32959670296960619395375032109508928491"));
+  for (int base : {2, 3, 5, 1'000'003}) {
+    REQUIRE(BigInteger::PowMod(BigInteger(base), mersenne - BigInteger(1), mersenne) == BigInteger(1));
+  }
+  REQUIRE(BigInteger::PowMod(BigInteger("123456789123456789"), BigInteger::Pow(BigInteger(2), 200) + BigInteger(3),
+                             BigInteger("1" + std::string(48, '0') + "14")) ==
+          BigInteger("78054644178970237604183833403348071216806156104097"));
+
+  REQUIRE(BigInteger::PowMod(BigInteger(-2), BigInteger(3), BigInteger(5)) == BigInteger(2));
+  REQUIRE(BigInteger::PowMod(BigInteger(-2), BigInteger(3), BigInteger(-5)) == BigInteger(2));
+  REQUIRE(BigInteger::PowMod(BigInteger(7), BigInteger(0), BigInteger(10)) == BigInteger(1));
+  REQUIRE(BigInteger::PowMod(BigInteger(7), BigInteger(0), BigInteger(1)) == BigInteger(0));
+  REQUIRE(BigInteger::PowMod(BigInteger(10), BigInteger(5), BigInteger(10)) == BigInteger(0));
+  REQUIRE_THROWS_AS(BigInteger::PowMod(BigInteger(2), BigInteger(3), BigInteger(0)),  // NOLINT
+                    BigIntegerDivisionByZero);
+  REQUIRE_THROWS_AS(BigInteger::PowMod(BigInteger(2), BigInteger(-3), BigInteger(7)),  // NOLINT
+                    BigIntegerException);
+
+  const std::pair<size_t, size_t> shapes[] = {{1, 3}, {19, 40}, {20, 1}, {60, 200}, {400, 90}, {2000, 25}};
+  uint32_t seed = 71;
+  for (const auto& [modulus_digits, exponent_digits] : shapes) {
+    for (int parity = 0; parity < 2; ++parity) {
+      BigInteger modulus(RandomNumber(modulus_digits, ++seed));
+      if ((modulus % 2 == 0) != (parity == 0)) {
+        ++modulus;
+      }
+      const BigInteger base = -BigInteger(RandomNumber(modulus_digits + 5, ++seed));
+      const BigInteger exponent(RandomNumber(exponent_digits, ++seed));
+      REQUIRE(BigInteger::PowMod(base, exponent, modulus) == NaivePowMod(base, exponent, modulus));
+    }
+  }
+
+  // Powers of two, including 2^(64 * (n - 1)) for n limbs.
+  for (const BigInteger& modulus : {BigInteger(1) << 64, BigInteger(1) << 128, -(BigInteger(1) << 192),
+                                    BigInteger(1) << 100}) {
+    REQUIRE(BigInteger::PowMod(BigInteger(3), BigInteger(100), modulus) ==
+            NaivePowMod(BigInteger(3), BigInteger(100), modulus));
+    const BigInteger base = -BigInteger(RandomNumber(70, ++seed));
+    const BigInteger exponent(RandomNumber(30, ++seed));
+    REQUIRE(BigInteger::PowMod(base, exponent, modulus) == NaivePowMod(base, exponent, modulus));
+  }
+}
+
+TEST_CASE("ModContext") {
+  REQUIRE_THROWS_AS(ModContext(BigInteger(0)), BigIntegerDivisionByZero);  // NOLINT
+  REQUIRE(ModContext(BigInteger(-7)).Modulus() == BigInteger(7));
+
+  uint32_t seed = 211;
+  std::vector<BigInteger> moduli = {BigInteger(1) << 64, BigInteger(1) << 128, -(BigInteger(1) << 192),
+                                    BigInteger(1) << 100};
+  for (size_t digits : {1, 19, 20, 77, 300, 1000}) {
+    for (int parity = 0; parity < 2; ++parity) {
+      BigInteger modulus(RandomNumber(digits, ++seed));
+      if ((modulus % 2 == 0) != (parity == 0)) {
+        ++modulus;
+      }
+      moduli.push_back(modulus);
+    }
+  }
+  for (BigInteger modulus : moduli) {
+    const ModContext context(modulus);
+    modulus = context.Modulus();
+    REQUIRE(context.IsMontgomery() == (modulus % 2 == 1));
+
+    const size_t digits = modulus.DigitCount();
+    const BigInteger a = BigInteger(RandomNumber(digits + 3, ++seed)) % modulus;
+    const BigInteger b = BigInteger(RandomNumber(digits, ++seed)) % modulus;
+    BigInteger x;
+    BigInteger y;
+    context.ToMontgomery(a, x);
+    context.ToMontgomery(b - modulus, y);
+
+    BigInteger result;
+    context.MulMod(x, y, result);
+    context.FromMontgomery(result, result);
+    REQUIRE(result == a * b % modulus);
+    context.SqrMod(x, result);
+    context.FromMontgomery(result, result);
+    REQUIRE(result == a * a % modulus);
+    context.AddMod(x, y, result);
+    context.FromMontgomery(result, result);
+    REQUIRE(result == (a + b) % modulus);
+    context.SubMod(y, x, result);
+    context.FromMontgomery(result, result);
+    REQUIRE(result == (b - a + modulus) % modulus);
+
+    // Outputs may alias the inputs.
+    BigInteger z = x;
+    context.MulMod(z, y, z);
+    context.AddMod(z, z, z);
+    context.SubMod(z, x, z);
+    context.FromMontgomery(z, z);
+    REQUIRE(z == (2 * (a * b % modulus) - a + 2 * modulus) % modulus);
+  }
+
+  if (kBigIntegerChecked) {
+    const ModContext context(BigInteger(1) << 64);
+    const BigInteger huge = BigInteger(1) << 300;
+    BigInteger result;
+    REQUIRE_THROWS_AS(context.MulMod(huge, BigInteger(3), result), BigIntegerException);           // NOLINT
+    REQUIRE_THROWS_AS(context.AddMod(BigInteger(1) << 64, BigInteger(0), result), BigIntegerException);  // NOLINT
+    REQUIRE_THROWS_AS(context.SubMod(BigInteger(1), BigInteger(-1), result), BigIntegerException);   // NOLINT
+    REQUIRE_THROWS_AS(context.SqrMod(huge, result), BigIntegerException);                          // NOLINT
+    REQUIRE_THROWS_AS(context.FromMontgomery(huge, result), BigIntegerException);                  // NOLINT
+  }
+}
+
+BigInteger NaiveGcd(BigInteger a, BigInteger b) {
+  while (b) {
+    a %= b;
+    std::swap(a, b);
+  }
+  return a.Absolute();
+}
+
+TEST_CASE("BitOperations") {
+  const BigInteger two_64("18446744073709551616");
+  REQUIRE((BigInteger(1) << 64) == two_64);
+  REQUIRE((BigInteger(-3) << 130) == BigInteger(-3) * two_64 * two_64 * BigInteger(4));
+  REQUIRE((two_64 >> 64) == BigInteger(1));
+  REQUIRE((two_64 >> 65) == BigInteger(0));
+  REQUIRE((BigInteger(-7) >> 1) == BigInteger(-4));
+  REQUIRE((BigInteger(-8) >> 3) == BigInteger(-1));
+  REQUIRE((-two_64 >> 64) == BigInteger(-1));
+  REQUIRE((-two_64 - BigInteger(1) >> 64) == BigInteger(-2));
+  REQUIRE((BigInteger(-1) >> 1000) == BigInteger(-1));
+  REQUIRE((BigInteger(0) << 1000) == BigInteger(0));
+
+  REQUIRE((BigInteger(12) & BigInteger(10)) == BigInteger(8));
+  REQUIRE((BigInteger(12) | BigInteger(10)) == BigInteger(14));
+  REQUIRE((BigInteger(12) ^ BigInteger(10)) == BigInteger(6));
+  REQUIRE((BigInteger(-3) & BigInteger(-5)) == BigInteger(-7));
+  REQUIRE((BigInteger(-3) | BigInteger(5)) == BigInteger(-3));
+  REQUIRE((BigInteger(-3) ^ BigInteger(5)) == BigInteger(-8));
+  REQUIRE((-two_64 & (two_64 - BigInteger(1))) == BigInteger(0));
+  REQUIRE((-two_64 & -two_64) == -two_64);
+  REQUIRE((-two_64 ^ BigInteger(-1)) == two_64 - BigInteger(1));
+  REQUIRE(~BigInteger(0) == BigInteger(-1));
+  REQUIRE(~-two_64 == two_64 - BigInteger(1));
+
+  REQUIRE(two_64.BitLength() == 65);
+  REQUIRE(BigInteger(-255).BitLength() == 8);
+  REQUIRE(BigInteger(0).BitLength() == 0);
+  REQUIRE((two_64 * BigInteger(255)).PopCount() == 8);
+  REQUIRE((two_64 * BigInteger(-24)).CountTrailingZeros() == 67);
+  REQUIRE(BigInteger(0).CountTrailingZeros() == 0);
+  REQUIRE(BigInteger(-12).TestBit(2));
+  REQUIRE_FALSE(BigInteger(-12).TestBit(3));
+  REQUIRE(BigInteger(-12).TestBit(4));
+  REQUIRE(BigInteger(-12).TestBit(1000));
+  REQUIRE_FALSE(BigInteger(12).TestBit(1000));
+
+  // Shifts agree with multiplication and floor division by powers of two.
+  uint32_t seed = 701;
+  for (size_t digits : {3, 40, 300}) {
+    const BigInteger value = -BigInteger(RandomNumber(digits, ++seed));
+    for (size_t shift : {1, 63, 64, 65, 200}) {
+      const BigInteger power = BigInteger::Pow(BigInteger(2), shift);
+      REQUIRE((value << shift) == value * power);
+      REQUIRE((value >> shift) == (value - power + BigInteger(1)) / power);
+      REQUIRE(((value >> shift) << shift | (value & (power - BigInteger(1)))) == value);
+      REQUIRE((value ^ value) == BigInteger(0));
+      REQUIRE((value | ~value) == BigInteger(-1));
+    }
+  }
+}
+
+TEST_CASE("LongCarryChains") {
+  // Long operands take the vector kernels; carries and borrows must cross whole blocks of limbs.
+  for (size_t limbs : {31, 32, 33, 40, 64, 100, 257}) {
+    const BigInteger power = BigInteger(1) << (64 * limbs);
+    const BigInteger all_ones = power - BigInteger(1);
+    REQUIRE(all_ones.PopCount() == 64 * limbs);
+    REQUIRE(all_ones + BigInteger(1) == power);
+    REQUIRE(BigInteger(1) + all_ones == power);
+    REQUIRE(power - all_ones == BigInteger(1));
+    REQUIRE(all_ones - power == BigInteger(-1));
+    REQUIRE(all_ones + all_ones == (power << 1) - BigInteger(2));
+
+    // Alternating all-ones and zero limbs that only fill up once both are added.
+    BigInteger pattern;
+    for (size_t i = 0; i < limbs; i += 2) {
+      pattern |= (BigInteger(1) << 64) - BigInteger(1) << (64 * i);
+    }
+    const BigInteger shifted = pattern << 64;
+    REQUIRE(pattern + shifted + BigInteger(1) == BigInteger(1) << (64 * (limbs + limbs % 2)));
+    REQUIRE(shifted + pattern - shifted == pattern);
+    REQUIRE(pattern - (shifted + pattern) == -shifted);
+  }
+
+  // (2^m - 1)(2^n - 1) keeps every partial product and every carry of the schoolbook rows maximal.
+  using Algorithm = BigInteger::MultiplyAlgorithm;
+  for (size_t a_limbs = 1; a_limbs <= 13; ++a_limbs) {
+    const BigInteger a = (BigInteger(1) << (64 * a_limbs)) - BigInteger(1);
+    REQUIRE(BigInteger::Square(a, Algorithm::kSchoolbook) ==
+            (BigInteger(1) << (128 * a_limbs)) - (a << 1) - BigInteger(1));
+    for (size_t b_limbs : {size_t{1}, size_t{4}, size_t{7}, size_t{8}, size_t{9}, size_t{12}, a_limbs}) {
+      const BigInteger b = (BigInteger(1) << (64 * b_limbs)) - BigInteger(1);
+      const BigInteger expected = (BigInteger(1) << (64 * (a_limbs + b_limbs))) - (a + b) - BigInteger(1);
+      REQUIRE(BigInteger::Multiply(a, b, Algorithm::kSchoolbook) == expected);
+      REQUIRE(BigInteger::Multiply(b, a, Algorithm::kSchoolbook) == expected);
+    }
+  }
+}
+
+TEST_CASE("KernelSetsAgree") {
+  using KernelSet = BigInteger::KernelSet;
+  const KernelSet initial = BigInteger::Kernels();
+  auto run = [](KernelSet limit) {
+    BigInteger::SetKernels(limit);
+    REQUIRE(BigInteger::Kernels() <= limit);
+    std::vector<BigInteger> results;
+    uint32_t seed = 71;
+    for (size_t digits : {19, 600, 610, 1300, 5000}) {
+      const BigInteger a(RandomNumber(digits, ++seed));
+      const BigInteger b(RandomNumber(digits, ++seed));
+      const BigInteger ones = (BigInteger(1) << (64 * (digits / 19))) - BigInteger(1);
+      results.insert(results.end(), {a + b, a - b, b - a, a * b, a * a, ones + BigInteger(1), ones * ones});
+      results.push_back(BigInteger(a < b) - BigInteger(a > b));
+      results.push_back(BigInteger((a + BigInteger(1)) > a) + BigInteger(a <= a));
+    }
+    return results;
+  };
+
+  const std::vector<BigInteger> expected = run(KernelSet::kScalar);
+  REQUIRE(BigInteger::Kernels() == KernelSet::kScalar);
+  REQUIRE(run(KernelSet::kAvx2) == expected);
+  REQUIRE(run(KernelSet::kAvx512) == expected);
+  BigInteger::SetKernels(initial);
+  REQUIRE(BigInteger::Kernels() == initial);
+
+  // Switching kernels while other threads multiply does not change their results.
+  const BigInteger a(RandomNumber(14000, 81));
+  const BigInteger b(RandomNumber(14000, 82));
+  const BigInteger product = BigInteger::Multiply(a, b, BigInteger::MultiplyAlgorithm::kKaratsuba);
+  const size_t parallel_threshold = BigInteger::ParallelThreshold();
+  BigInteger::SetParallelThreshold(100);
+  BigInteger::SetMultiplyThreads(4);
+  auto worker = std::async(std::launch::async, [&] { return BigInteger::Multiply(a, b); });
+  for (KernelSet limit : {KernelSet::kScalar, KernelSet::kAvx512, KernelSet::kAvx2, initial}) {
+    BigInteger::SetKernels(limit);
+  }
+  REQUIRE(worker.get() == product);
+  BigInteger::SetMultiplyThreads(1);
+  BigInteger::SetParallelThreshold(parallel_threshold);
+  REQUIRE(BigInteger::Kernels() == initial);
+}
+
+TEST_CASE("Statistics") {
+  using Operation = BigInteger::Operation;
+  using Tier = BigInteger::Tier;
+  BigInteger::ResetStatistics();
+  const BigInteger a(RandomNumber(5000, 91));
+  const BigInteger b(RandomNumber(2500, 92));
+  BigInteger product = a * b;
+  BigInteger square = a * a;
+  BigInteger quotient = product / b;
+  std::ostringstream oss;
+  oss << quotient;
+  ++quotient;
+  const bool less = quotient < a;
+
+  const BigInteger::Statistics statistics = BigInteger::StatisticsSnapshot();
+  auto stats = [&statistics](Operation operation) { return statistics[static_cast<size_t>(operation)]; };
+  if (!kBigIntegerStatistics) {
+    for (const auto& operation : statistics) {
+      REQUIRE(operation.calls == 0);
+    }
+    return;
+  }
+  REQUIRE_FALSE(less);
+  REQUIRE(stats(Operation::kParse).calls == 2);
+  REQUIRE(stats(Operation::kParse).tiers[static_cast<size_t>(Tier::kSubquadratic)] == 2);
+  REQUIRE(stats(Operation::kSquare).calls == 1);
+  REQUIRE(stats(Operation::kSquare).tiers[static_cast<size_t>(Tier::kToom3)] == 1);
+  REQUIRE(stats(Operation::kMultiply).calls == 1);
+  REQUIRE(stats(Operation::kMultiply).tiers[static_cast<size_t>(Tier::kKaratsuba)] == 1);
+  // The divisions of the print and the arithmetic inside the products are not recorded on their own.
+  REQUIRE(stats(Operation::kDivide).calls == 1);
+  REQUIRE(stats(Operation::kDivide).tiers[static_cast<size_t>(Tier::kSubquadratic)] == 1);
+  REQUIRE(stats(Operation::kPrint).calls == 1);
+  REQUIRE(stats(Operation::kIncrement).calls == 1);
+  REQUIRE(stats(Operation::kCompare).calls == 1);
+  REQUIRE(stats(Operation::kAdd).calls == 0);
+  REQUIRE(stats(Operation::kSubtract).calls == 0);
+  // a has 260 limbs: bucket 9 holds [256, 512).
+  REQUIRE(stats(Operation::kSquare).sizes[9] == 1);
+  REQUIRE(stats(Operation::kSquare).limbs == 260);
+  REQUIRE(stats(Operation::kSquare).allocations >= 1);
+  REQUIRE(stats(Operation::kDivide).nanoseconds > 0);
+  REQUIRE(std::string(BigInteger::OperationName(Operation::kIncrement)) == "increment");
+  REQUIRE(std::string(BigInteger::TierName(Tier::kNtt)) == "ntt");
+
+  BigInteger::ResetStatistics();
+  REQUIRE(BigInteger::StatisticsSnapshot()[static_cast<size_t>(Operation::kSquare)].calls == 0);
+
+  // A Toom-3 product, also with its pointwise products on other threads, and one equality test.
+  const BigInteger c(RandomNumber(5000, 93));
+  BigInteger::SetMultiplyThreads(3);
+  const size_t parallel_threshold = BigInteger::ParallelThreshold();
+  BigInteger::SetParallelThreshold(8);
+  product = a * c;
+  BigInteger::SetParallelThreshold(parallel_threshold);
+  BigInteger::SetMultiplyThreads(1);
+  const bool equal = product == square;
+  const BigInteger::Statistics toom = BigInteger::StatisticsSnapshot();
+  REQUIRE_FALSE(equal);
+  REQUIRE(toom[static_cast<size_t>(Operation::kMultiply)].calls == 1);
+  REQUIRE(toom[static_cast<size_t>(Operation::kMultiply)].tiers[static_cast<size_t>(Tier::kToom3)] == 1);
+  REQUIRE(toom[static_cast<size_t>(Operation::kAdd)].calls == 0);
+  REQUIRE(toom[static_cast<size_t>(Operation::kSubtract)].calls == 0);
+  REQUIRE(toom[static_cast<size_t>(Operation::kCompare)].calls == 1);
+}
+
+TEST_CASE("Roots") {
+  REQUIRE(BigInteger::Sqrt(BigInteger(0)) == BigInteger(0));
+  REQUIRE(BigInteger::Sqrt(BigInteger(15)) == BigInteger(3));
+  REQUIRE(BigInteger::Sqrt(BigInteger(16)) == BigInteger(4));
+  REQUIRE(BigInteger::Root(BigInteger(-27), 3) == BigInteger(-3));
+  REQUIRE(BigInteger::Root(BigInteger(-26), 3) == BigInteger(-2));
+  REQUIRE(BigInteger::Root(BigInteger(1000), 1) == BigInteger(1000));
+  REQUIRE(BigInteger::Root(BigInteger(1000), 64) == BigInteger(1));
+  REQUIRE_THROWS_AS(BigInteger::Sqrt(BigInteger(-4)), BigIntegerException);     // NOLINT
+  REQUIRE_THROWS_AS(BigInteger::Root(BigInteger(8), 0), BigIntegerException);  // NOLINT
+
+  const BigInteger max_limb("18446744073709551615");
+  REQUIRE(BigInteger::Sqrt(max_limb) == BigInteger(4294967295));
+  REQUIRE(BigInteger::Sqrt(max_limb * max_limb) == max_limb);
+  REQUIRE(BigInteger::Sqrt(max_limb * max_limb - BigInteger(1)) == max_limb - BigInteger(1));
+
+  uint32_t seed = 613;
+  for (size_t digits : {5, 25, 60, 400, 3000, 9000}) {
+    const BigInteger root(RandomNumber(digits, ++seed));
+    const BigInteger square = root * root;
+    const auto [exact, zero] = BigInteger::SqrtRem(square);
+    REQUIRE(exact == root);
+    REQUIRE(zero == BigInteger(0));
+    const auto [below, remainder] = BigInteger::SqrtRem(square - BigInteger(1));
+    REQUIRE(below == root - BigInteger(1));
+    REQUIRE(remainder == BigInteger(2) * root - BigInteger(2));
+    REQUIRE(BigInteger::IsPerfectSquare(square));
+    REQUIRE_FALSE(BigInteger::IsPerfectSquare(square + BigInteger(1)));
+    REQUIRE_FALSE(BigInteger::IsPerfectSquare(square - BigInteger(1)));
+
+    for (uint64_t k : {3, 5, 10}) {
+      if (digits * k > BigInteger::MaxDigitCount() / 2) {
+        continue;
+      }
+      const BigInteger power = BigInteger::Pow(root, k);
+      REQUIRE(BigInteger::Root(power, k) == root);
+      REQUIRE(BigInteger::Root(power - BigInteger(1), k) == root - BigInteger(1));
+      REQUIRE(BigInteger::Root(power + root, k) == root);
+    }
+  }
+
+  int squares = 0;
+  for (int i = -5; i < 2000; ++i) {
+    squares += BigInteger::IsPerfectSquare(BigInteger(i)) ? 1 : 0;
+  }
+  REQUIRE(squares == 45);
+}
+
+TEST_CASE("Gcd") {
+  REQUIRE(BigInteger::Gcd(BigInteger(0), BigInteger(0)) == BigInteger(0));
+  REQUIRE(BigInteger::Gcd(BigInteger(-12), BigInteger(0)) == BigInteger(12));
+  REQUIRE(BigInteger::Gcd(BigInteger(0), BigInteger(-12)) == BigInteger(12));
+  REQUIRE(BigInteger::Gcd(BigInteger(-12), BigInteger(18)) == BigInteger(6));
+  REQUIRE(BigInteger::Lcm(BigInteger(-4), BigInteger(6)) == BigInteger(12));
+  REQUIRE(BigInteger::Lcm(BigInteger(0), BigInteger(6)) == BigInteger(0));
+
+  // Consecutive Fibonacci numbers take the longest run of single-quotient steps.
+  BigInteger previous(1);
+  BigInteger current(1);
+  for (int i = 0; i < 3000; ++i) {
+    previous += current;
+    std::swap(previous, current);
+  }
+  REQUIRE(BigInteger::Gcd(current, previous) == BigInteger(1));
+
+  const std::pair<size_t, size_t> shapes[] = {{1, 1}, {20, 19}, {40, 40}, {300, 120}, {1000, 998}, {3000, 40}};
+  uint32_t seed = 307;
+  for (const auto& [lhs_digits, rhs_digits] : shapes) {
+    const BigInteger common(RandomNumber(rhs_digits / 2 + 1, ++seed));
+    const BigInteger a = BigInteger(RandomNumber(lhs_digits, ++seed)) * common;
+    const BigInteger b = -BigInteger(RandomNumber(rhs_digits, ++seed)) * common;
+    const BigInteger expected = NaiveGcd(a, b);
+    REQUIRE(BigInteger::Gcd(a, b) == expected);
+    REQUIRE(BigInteger::Gcd(b, a) == expected);
+    REQUIRE(BigInteger::Lcm(a, b) == (a * b).Absolute() / expected);
+
+    BigInteger x;
+    BigInteger y;
+    REQUIRE(BigInteger::ExtendedGcd(a, b, x, y) == expected);
+    REQUIRE(a * x + b * y == expected);
+    REQUIRE(BigInteger::ExtendedGcd(b, -a, x, y) == expected);
+    REQUIRE(b * x - a * y == expected);
+  }
+
+  BigInteger x;
+  BigInteger y;
+  REQUIRE(BigInteger::ExtendedGcd(BigInteger(0), BigInteger(-5), x, y) == BigInteger(5));
+  REQUIRE(BigInteger(-5) * y == BigInteger(5));
+}
+
+TEST_CASE("HalfGcdMatchesLehmer") {
+  const size_t default_threshold = BigInteger::GcdThreshold();
+  const std::pair<size_t, size_t> shapes[] = {{300, 300}, {2000, 1990}, {5000, 2600}, {9000, 9000}, {12000, 400}};
+
+  std::vector<std::pair<BigInteger, BigInteger>> inputs;
+  uint32_t seed = 521;
+  for (const auto& [lhs_digits, rhs_digits] : shapes) {
+    const BigInteger common(RandomNumber(rhs_digits / 3 + 1, ++seed));
+    const BigInteger a = BigInteger(RandomNumber(lhs_digits, ++seed)) * common;
+    const BigInteger b = -BigInteger(RandomNumber(rhs_digits, ++seed)) * common;
+    inputs.emplace_back(a, b);
+  }
+  BigInteger previous(1);
+  BigInteger current(1);
+  for (int i = 0; i < 20000; ++i) {
+    previous += current;
+    std::swap(previous, current);
+  }
+  inputs.emplace_back(current, previous);
+  inputs.emplace_back(current, current + BigInteger(1));
+
+  for (const auto& [a, b] : inputs) {
+    BigInteger::SetGcdThreshold(std::numeric_limits<size_t>::max());
+    const BigInteger expected = BigInteger::Gcd(a, b);
+
+    for (size_t threshold : {size_t{4}, size_t{7}, size_t{16}, default_threshold}) {
+      BigInteger::SetGcdThreshold(threshold);
+      REQUIRE(BigInteger::Gcd(a, b) == expected);
+      REQUIRE(BigInteger::Gcd(b, a) == expected);
+
+      BigInteger x;
+      BigInteger y;
+      REQUIRE(BigInteger::ExtendedGcd(a, b, x, y) == expected);
+      REQUIRE(a * x + b * y == expected);
+    }
+  }
+  BigInteger::SetGcdThreshold(default_threshold);
+}
+
+TEST_CASE("ModInverse") {
+  REQUIRE(BigInteger::ModInverse(BigInteger(3), BigInteger(11)) == BigInteger(4));
+  REQUIRE(BigInteger::ModInverse(BigInteger(-3), BigInteger(11)) == BigInteger(7));
+  REQUIRE(BigInteger::ModInverse(BigInteger(3), BigInteger(-11)) == BigInteger(4));
+  REQUIRE(BigInteger::ModInverse(BigInteger(5), BigInteger(1)) == BigInteger(0));
+  REQUIRE_THROWS_AS(BigInteger::ModInverse(BigInteger(6), BigInteger(9)), BigIntegerException);      // NOLINT
+  REQUIRE_THROWS_AS(BigInteger::ModInverse(BigInteger(6), BigInteger(0)), BigIntegerDivisionByZero);  // NOLINT
+
+  const BigInteger modulus = BigInteger::Pow(BigInteger(2), 521) - BigInteger(1);
+  uint32_t seed = 401;
+  for (size_t digits : {1, 30, 150, 400}) {
+    const BigInteger a = -BigInteger(RandomNumber(digits, ++seed));
+    const BigInteger inverse = BigInteger::ModInverse(a, modulus);
+    REQUIRE(inverse >= 0);
+    REQUIRE(inverse < modulus);
+    REQUIRE((a * inverse % modulus + modulus) % modulus == BigInteger(1));
+  }
+}
+
 #endif  // BIG_INTEGER_DIVISION_IMPLEMENTED
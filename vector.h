@@ -4,6 +4,7 @@
 #define VECTOR_MEMORY_IMPLEMENTED
 
 #include <cstddef>
+#include <cstring>
 #include <utility>
 #include <stdexcept>
 #include <iterator>
@@ -256,20 +257,9 @@ class Vector {
     SizeType desired = new_size;
     auto [new_data, new_cap] = AllocateMoreBuffer(desired);
 
-    SizeType moved = 0;
-    try {
-      for (; moved < size_; ++moved) {
-        ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
-    SizeType constructed_tail = moved;
+    SizeType constructed_tail = size_;
     try {
       for (; constructed_tail < new_size; ++constructed_tail) {
         ::new (static_cast<void*>(new_data + constructed_tail)) T();
@@ -320,20 +310,9 @@ class Vector {
     SizeType desired = new_size;
     auto [new_data, new_cap] = AllocateMoreBuffer(desired);
 
-    SizeType moved = 0;
-    try {
-      for (; moved < size_; ++moved) {
-        ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
-    SizeType i = moved;
+    SizeType i = size_;
     try {
       for (; i < new_size; ++i) {
         ::new (static_cast<void*>(new_data + i)) T(value);
@@ -363,18 +342,7 @@ class Vector {
 
     auto [new_data, confirmed_cap] = AllocateMoreBuffer(new_cap);
 
-    SizeType moved = 0;
-    try {
-      for (; moved < size_; ++moved) {
-        ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
     for (SizeType j = 0; j < size_; ++j) {
       std::destroy_at(data_ + j);
@@ -395,18 +363,7 @@ class Vector {
     }
 
     auto new_data = static_cast<Pointer>(::operator new(size_ * sizeof(T)));
-    SizeType i = 0;
-    try {
-      for (; i < size_; ++i) {
-        ::new (static_cast<void*>(new_data + i)) T(std::move_if_noexcept(data_[i]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < i; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
     for (SizeType j = 0; j < size_; ++j) {
       std::destroy_at(data_ + j);
@@ -434,24 +391,13 @@ class Vector {
     SizeType desired = size_ + 1;
     auto [new_data, new_cap] = AllocateMoreBuffer(desired);
 
-    SizeType moved = 0;
-    try {
-      for (; moved < size_; ++moved) {
-        ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
     SizeType idx_new = size_;
     try {
       ::new (static_cast<void*>(new_data + idx_new)) T(value);
     } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
+      for (SizeType j = 0; j < size_; ++j) {
         std::destroy_at(new_data + j);
       }
       ::operator delete(new_data);
@@ -465,7 +411,7 @@ class Vector {
 
     data_ = new_data;
     capacity_ = new_cap;
-    size_ = moved + 1;
+    ++size_;
   }
 
   void PushBack(T&& value) {
@@ -478,24 +424,13 @@ class Vector {
     SizeType desired = size_ + 1;
     auto [new_data, new_cap] = AllocateMoreBuffer(desired);
 
-    SizeType moved = 0;
-    try {
-      for (; moved < size_; ++moved) {
-        ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
     SizeType idx_new = size_;
     try {
       ::new (static_cast<void*>(new_data + idx_new)) T(std::move(value));
     } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
+      for (SizeType j = 0; j < size_; ++j) {
         std::destroy_at(new_data + j);
       }
       ::operator delete(new_data);
@@ -509,7 +444,7 @@ class Vector {
 
     data_ = new_data;
     capacity_ = new_cap;
-    size_ = moved + 1;
+    ++size_;
   }
 
   template <typename... Args>
@@ -523,24 +458,13 @@ class Vector {
     SizeType desired = size_ + 1;
     auto [new_data, new_cap] = AllocateMoreBuffer(desired);
 
-    SizeType moved = 0;
-    try {
-      for (; moved < size_; ++moved) {
-        ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
-      }
-    } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
-        std::destroy_at(new_data + j);
-      }
-      ::operator delete(new_data);
-      throw;
-    }
+    MoveElementsTo(new_data);
 
     SizeType idx_new = size_;
     try {
       ::new (static_cast<void*>(new_data + idx_new)) T(std::forward<Args>(args)...);
     } catch (...) {
-      for (SizeType j = 0; j < moved; ++j) {
+      for (SizeType j = 0; j < size_; ++j) {
         std::destroy_at(new_data + j);
       }
       ::operator delete(new_data);
@@ -554,7 +478,7 @@ class Vector {
 
     data_ = new_data;
     capacity_ = new_cap;
-    size_ = moved + 1;
+    ++size_;
   }
 
   void PopBack() {
@@ -651,6 +575,31 @@ class Vector {
     }
   }
 
+  // Moves the elements into new_data, or copies them when T's move constructor may throw. If that
+  // throws, the elements built so far are destroyed, new_data is freed and the exception propagates.
+  // Trivially copyable elements are relocated with one memcpy, which the C library dispatches to the
+  // widest copy loop the CPU supports.
+  void MoveElementsTo(Pointer new_data) {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+      if (size_ > 0) {
+        std::memcpy(static_cast<void*>(new_data), static_cast<const void*>(data_), size_ * sizeof(T));
+      }
+    } else {
+      SizeType moved = 0;
+      try {
+        for (; moved < size_; ++moved) {
+          ::new (static_cast<void*>(new_data + moved)) T(std::move_if_noexcept(data_[moved]));
+        }
+      } catch (...) {
+        for (SizeType j = 0; j < moved; ++j) {
+          std::destroy_at(new_data + j);
+        }
+        ::operator delete(new_data);
+        throw;
+      }
+    }
+  }
+
   std::pair<Pointer, SizeType> AllocateMoreBuffer(SizeType min_cap) {
     SizeType new_cap = (capacity_ == 0 ? 1 : capacity_ * 2);
     if (new_cap < min_cap) {